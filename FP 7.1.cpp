@@ -1,6 +1,10 @@
 //+==========================================+
 //      EPEECT PARKING MANAGEMENT SYSTEM
 //+==========================================+
+//   g++ -std=c++20 -O2 -pthread "FP 7.1.cpp" -o parking
+//   Add -DEPEECT_BENCH for the benchmark build (see BENCHMARKS). On x86-64
+//   the AVX2 fee kernel is compiled in and chosen at run time when the CPU
+//   has AVX2, so no -mavx2 is needed; other targets use the scalar code.
 
 #include <iostream>
 #include <string>  
@@ -11,164 +15,3933 @@
 #include <filesystem>
 #include <chrono>
 #include <ctime> 
+#include <cstdint>
+#include <cstring>
+#include <charconv>
+#include <cerrno>
+#include <cmath>
+#include <memory>
+#include <algorithm>
+#include <numeric>
+#include <array>
+#include <bit>
+#include <string_view>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <fcntl.h>
+#ifdef _WIN32
+    #include <io.h>
+    #include <sys/stat.h>
+#else
+    #include <unistd.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+#endif
+#ifdef __linux__
+    #include <csignal>
+    #include <deque>
+    #include <unordered_map>
+    #include <sys/epoll.h>
+    #include <sys/eventfd.h>
+    #include <sys/signalfd.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+#endif
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+    #include <immintrin.h>
+    #define EPEECT_FEE_AVX2     // Batch fee kernel with runtime AVX2 dispatch
+    #define EPEECT_PLATE_SSE2   // Plates compared as one 128-bit vector
+#endif
 using namespace std;
 
 //+==========================================+
 //       STRUCTURES AND CONSTANTS
 //+==========================================+
 
+// Session status flags (bitmask)
+constexpr uint8_t SESSION_PARKED    = 1 << 0;     // Vehicle is still inside
+constexpr uint8_t SESSION_EXITED    = 1 << 1;     // Vehicle has left and paid
+constexpr uint8_t SESSION_OVERNIGHT = 1 << 2;     // Overnight rate was charged
+constexpr uint8_t SESSION_LOST_CARD = 1 << 3;     // Lost card fee was charged
+
+constexpr int PLATE_LENGTH = 16;                  // Longest license plate stored inline
+
+// License plate stored inline and zero-padded, so it never allocates.
+// Plates are kept normalized (see normalizePlate), so two plates are the
+// same exactly when their 16 bytes are, and comparing them is one vector
+// compare instead of a string comparison.
+struct alignas(16) PlateText {
+    char text[PLATE_LENGTH] = {};
+
+    PlateText() = default;
+    explicit PlateText(const char (&bytes)[PLATE_LENGTH]) { memcpy(text, bytes, PLATE_LENGTH); }
+
+    string_view view() const {
+        size_t length = 0;
+        while (length < PLATE_LENGTH && text[length] != '\0') length++;
+        return string_view(text, length);
+    }
+
+    bool operator==(const PlateText &other) const {
+    #ifdef EPEECT_PLATE_SSE2
+        __m128i equal = _mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<const __m128i *>(text)),
+                                       _mm_load_si128(reinterpret_cast<const __m128i *>(other.text)));
+        return _mm_movemask_epi8(equal) == 0xFFFF;
+    #else
+        return memcmp(text, other.text, PLATE_LENGTH) == 0;
+    #endif
+    }
+};
+
+// One parking session, as read back from the session table
 struct ParkingLog {
-    string licensePlate;    // Vehicle's license plate
-    string entryTime;       // Entry time of the vehicle
-    string exitTime;        // Exit time of the vehicle
-    float fee;              // Parking fee
+    PlateText licensePlate;     // Vehicle's license plate
+    int64_t   entryTime;        // Entry time (epoch minutes)
+    int64_t   exitTime;         // Exit time (epoch minutes)
+    int64_t   fee;              // Parking fee in centavos
+    uint8_t   status;           // SESSION_* flags
+    int32_t   bay;              // Assigned bay number (0-based)
+};
+
+// Growable array stored in fixed-size chunks. Growing only appends a new
+// chunk, so records never move and an index stays valid for the life of
+// the array. Memory grows one chunk (CHUNK_SIZE records) at a time.
+// Chunks can also be borrowed from a mapped snapshot, which the array uses
+// in place and never frees.
+template <typename T>
+struct ChunkedArray {
+    static constexpr int    CHUNK_BITS = 12;
+    static constexpr size_t CHUNK_SIZE = size_t(1) << CHUNK_BITS;   // 4096 records per chunk
+    static constexpr size_t CHUNK_MASK = CHUNK_SIZE - 1;
+
+    struct ChunkDeleter {
+        bool owned = true;      // False for chunks borrowed from a snapshot
+        void operator()(T *chunk) const { if (owned) delete[] chunk; }
+    };
+
+    vector<unique_ptr<T[], ChunkDeleter>> chunks;
+    size_t count = 0;
+
+    size_t size() const { return count; }
+    bool   empty() const { return count == 0; }
+    T       &operator[](size_t i)       { return chunks[i >> CHUNK_BITS][i & CHUNK_MASK]; }
+    const T &operator[](size_t i) const { return chunks[i >> CHUNK_BITS][i & CHUNK_MASK]; }
+
+    // Dense view of one chunk, used by full-table scans
+    size_t   chunkCount() const { return chunks.size(); }
+    size_t   chunkLength(size_t c) const { return min(CHUNK_SIZE, count - (c << CHUNK_BITS)); }
+    const T *chunk(size_t c) const { return chunks[c].get(); }
+
+    // Append a default-constructed record and return it
+    T &emplace_back() {
+        if ((count & CHUNK_MASK) == 0 && (count >> CHUNK_BITS) == chunks.size()) {
+            chunks.emplace_back(new T[CHUNK_SIZE]());
+        }
+        return (*this)[count++];
+    }
+
+    void push_back(const T &value) { emplace_back() = value; }
+
+    // Use `count` records laid out as whole chunks at `data` without copying
+    void adopt(T *data, size_t records) {
+        chunks.clear();
+        for (size_t offset = 0; offset < records; offset += CHUNK_SIZE) {
+            chunks.emplace_back(data + offset, ChunkDeleter{false});
+        }
+        count = records;
+    }
+};
+
+// Parking sessions stored column by column, every column indexed by row. Times
+// are epoch minutes: minutes since 1970-01-01 00:00 on the lot's wall clock.
+struct SessionTable {
+    ChunkedArray<PlateText> plates;         // License plates
+    ChunkedArray<int64_t>   entryTimes;     // Entry time (epoch minutes)
+    ChunkedArray<int64_t>   exitTimes;      // Exit time (epoch minutes), -1 while parked
+    ChunkedArray<int64_t>   fees;           // Fee in centavos, 0 while parked
+    ChunkedArray<uint8_t>   statuses;       // SESSION_* flags
+    ChunkedArray<int32_t>   bays;           // Assigned bay number (0-based)
+
+    size_t size() const { return statuses.size(); }
+    bool   empty() const { return statuses.empty(); }
+
+    int        append(const PlateText &plate, int64_t entryTime, int32_t bay);
+    ParkingLog row(size_t i) const;
+};
+
+// Open-addressing index of active sessions keyed by license plate.
+// Linear probing with backward-shift deletion, so there are no tombstones
+// and a lookup never allocates. Slots only hold a hash and a log index;
+// the plate itself is compared against the log it points to.
+struct PlateIndex {
+    struct Slot {
+        uint32_t hash = 0;  // Plate hash (never 0), 0 marks an empty slot
+        int      row  = -1; // Index of the active session in logs
+    };
+    vector<Slot> slots = vector<Slot>(64);
+    int count = 0;
+
+    int  find(const PlateText &plate, const SessionTable &logs) const;
+    void insert(const PlateText &plate, int row);
+    void erase(const PlateText &plate, const SessionTable &logs);
+
+private:
+    size_t homeOf(uint32_t hash) const;
+    void   grow();
+};
+
+// Dense set of the rows of currently parked vehicles. Removal swaps the last
+// row into the hole, so the set stays packed and a pass over it costs
+// O(occupancy) no matter how long the history grows.
+struct ActiveSet {
+    vector<int>           rows;     // Rows of parked vehicles, in no particular order
+    ChunkedArray<int32_t> slots;    // Position of each table row in rows, -1 if not parked
+
+    size_t size() const { return rows.size(); }
+    bool   empty() const { return rows.empty(); }
+
+    void insert(int row);
+    void erase(int row);
+};
+
+// Rows ordered by one int64 key (a time or a fee) for range queries, kept in
+// blocks of up to 2 * BLOCK_ENTRIES so an insert only shifts one block
+struct SortedIndex {
+    static constexpr size_t BLOCK_ENTRIES = 128;
+
+    struct Entry {
+        int64_t key;
+        int     row;
+        bool operator<(const Entry &other) const { return key < other.key || (key == other.key && row < other.row); }
+    };
+    vector<vector<Entry>> blocks;   // Consecutive stretches of the order, none empty
+    vector<Entry>         lows;     // First entry of each block
+    size_t                entries = 0;
+
+    size_t size() const { return entries; }
+
+    size_t estimate(int64_t from, int64_t to) const;
+    template <typename Visit>
+    void   forEach(int64_t from, int64_t to, Visit &&visit) const;
+    void   insert(int64_t key, int row);
+    void   rebuild(vector<Entry> sorted);
+
+private:
+    size_t firstBlock(int64_t key) const;
+};
+
+// Secondary indexes over the session table, kept current by every entry and
+// exit. Status needs no index of its own: open sessions are the ActiveSet and
+// closed ones are exactly the rows in byExit and byFee.
+struct SessionIndexes {
+    SortedIndex byEntry;            // Every session, by entry time
+    SortedIndex byExit;             // Closed sessions, by exit time
+    SortedIndex byFee;              // Closed sessions, by fee
+};
+
+// Session status a query can ask for
+enum QueryStatus {
+    QUERY_ANY,
+    QUERY_OPEN,                     // Still parked
+    QUERY_CLOSED                    // Exited and paid
+};
+
+// Range predicates over the session log, all of which must hold. Ranges are
+// half-open [from, to) and default to everything; exit and fee terms only
+// match closed sessions.
+struct SessionQuery {
+    QueryStatus status   = QUERY_ANY;
+    int64_t     entryFrom = INT64_MIN, entryTo = INT64_MAX;    // Entry time (epoch minutes)
+    int64_t     exitFrom  = INT64_MIN, exitTo  = INT64_MAX;    // Exit time (epoch minutes)
+    int64_t     feeFrom   = INT64_MIN, feeTo   = INT64_MAX;    // Fee (centavos)
+
+    bool restricts() const;
+};
+
+// Bigram index over parked and recently exited plates, for finding a car
+// from a partial or misread plate. One slot per indexed session.
+struct PlateSearch {
+    static constexpr int GRAM_BITS = 12;
+
+    vector<PlateText> plates;                   // Plate per slot
+    vector<int>       rows;                     // Session row per slot
+    vector<uint64_t>  signatures;               // Bit signatureBit(g) set for each bigram g, per slot
+    vector<uint8_t>   lengths;                  // Plate length per slot
+    size_t lengthCounts[PLATE_LENGTH + 1] = {}; // Slots by plate length
+    vector<vector<uint32_t>> grams = vector<vector<uint32_t>>(1 << GRAM_BITS); // Slots by bigram, ascending
+
+    static int gramOf(char a, char b) { return ((a & 63) << 6) | (b & 63); }
+    static uint64_t signatureBit(int gram) { return uint64_t(1) << ((uint32_t(gram) * 0x9E3779B1u) >> 26); }
+
+    void   add(const PlateText &plate, int row);
+    void   clear();
+    size_t size() const { return rows.size(); }
+};
+
+// How a plate matched a search, best first
+enum PlateMatchKind {
+    PLATE_EXACT,                    // The whole plate
+    PLATE_PREFIX,                   // The start of the plate
+    PLATE_CONTAINS,                 // Somewhere inside the plate
+    PLATE_CLOSE                     // One character wrong, missing or extra
+};
+
+// One search result
+struct PlateMatch {
+    int            row;             // Latest session with the plate
+    PlateMatchKind kind;
+};
+
+// What one exit was charged, split the way LotStats adds it up (centavos)
+struct ExitCharge {
+    int64_t timeFee      = 0;   // Hourly and overtime charges for the stay
+    int64_t overnightFee = 0;   // 0 unless charged
+    int64_t lostCardFee  = 0;   // 0 unless charged
+
+    int64_t total() const { return timeFee + overnightFee + lostCardFee; }
+};
+
+// Running totals over the session table, updated by every entry and exit so
+// the stats screen and reports read them in O(1) instead of walking the
+// logs. Amounts are centavos and stays are minutes. Plain integers only, so
+// the snapshot stores it as-is.
+struct LotStats {
+    static constexpr int DWELL_BUCKETS = 8;         // Stay-length classes, see DWELL_LIMITS
+    static constexpr int RECENT_DAYS   = 8;         // Days kept in the daily totals ring
+
+    int64_t entries          = 0;   // Sessions opened
+    int64_t exits            = 0;   // Sessions closed
+    int64_t overnightExits   = 0;   // Exits charged the overnight fee
+    int64_t lostCardExits    = 0;   // Exits charged the lost card fee
+    int64_t timeRevenue      = 0;   // Hourly and overtime charges
+    int64_t overnightRevenue = 0;   // Overnight fees
+    int64_t lostCardRevenue  = 0;   // Lost card fees
+    int64_t dwellMinutes     = 0;   // Length of every closed stay, summed
+    int64_t dwellHistogram[DWELL_BUCKETS] = {};
+    // Revenue and exits per exit day for the latest RECENT_DAYS days, in a
+    // ring indexed by day. dayKeys holds the day (since 1970-01-01) plus one,
+    // 0 for a slot not used yet.
+    int64_t dayKeys[RECENT_DAYS]    = {};
+    int64_t dayRevenue[RECENT_DAYS] = {};
+    int64_t dayExits[RECENT_DAYS]   = {};
+
+    static int64_t dayOf(int64_t time) { return time / 1440 - (time % 1440 < 0); }     // Epoch minutes to days
+    static int     daySlot(int64_t day) { return (int)(((day % RECENT_DAYS) + RECENT_DAYS) % RECENT_DAYS); }
+
+    int64_t openSessions() const { return entries - exits; }
+    int64_t revenue() const { return timeRevenue + overnightRevenue + lostCardRevenue; }
+    int64_t revenueOn(int64_t day) const;
+    int64_t exitsOn(int64_t day) const;
+    void    noteExit(int64_t exitTime, int64_t minutes, int64_t timeFee, int64_t overnightFee, int64_t lostCardFee);
+
+private:
+    int64_t *claimDay(int64_t day);
+};
+
+// One hour of occupancy, rolled up from its minutes once it leaves the
+// per-minute window
+struct OccupancyHour {
+    int32_t peak;               // Highest level at the end of any of its minutes
+    int32_t peakMinute;         // First minute (0-59) that reached it
+    int32_t low;                // Lowest level
+    int32_t fullMinutes;        // Minutes that ended with every bay taken
+    int32_t occupiedMinutes;    // Bay-minutes used; / 60 is the average level
+};
+
+// Occupancy over a range of minutes, from OccupancyTimeline::summarize
+struct OccupancySummary {
+    int32_t peak = 0;
+    int64_t peakTime = 0;           // First minute the peak was reached
+    int32_t low = 0;
+    int64_t fullMinutes = 0;        // Minutes with every bay taken
+    int64_t occupiedMinutes = 0;    // Bay-minutes used
+    int64_t minutes = 0;            // Minutes covered; 0 if the range had no history
+};
+
+// Occupancy history kept as entries and exits happen: per-minute net changes
+// for the latest day, hourly roll-ups behind it. Plain data, snapshotted as-is.
+struct OccupancyTimeline {
+    static constexpr int WINDOW_HOURS   = 24;                   // Per-minute detail
+    static constexpr int WINDOW_MINUTES = WINDOW_HOURS * 60;
+    static constexpr int HISTORY_HOURS  = 24 * 31;              // Hourly history behind the window
+
+    int64_t head     = INT64_MIN;   // Latest event minute, INT64_MIN before the first; the window ends with its hour
+    int64_t start    = 0;           // Earliest minute with history
+    int32_t base     = 0;           // Occupancy just before the window
+    int32_t current  = 0;           // Occupancy after every event so far
+    int32_t capacity = 0;           // Bays in the lot, for time at full
+    int32_t       changes[WINDOW_MINUTES] = {};
+    OccupancyHour hours[HISTORY_HOURS]    = {};
+
+    static int64_t floorMod(int64_t value, int64_t modulus) { return ((value % modulus) + modulus) % modulus; }
+    static int64_t hourOf(int64_t time) { return (time - floorMod(time, 60)) / 60; }
+    static int     minuteSlot(int64_t time) { return (int)floorMod(time, WINDOW_MINUTES); }
+    int64_t windowStart() const { return (hourOf(head) - WINDOW_HOURS + 1) * 60; }
+
+    void             record(int64_t time, int delta, int totalBays);
+    OccupancySummary summarize(int64_t from, int64_t to) const;
+
+private:
+    void advance(int64_t time);
+    void rollUp(int64_t hour);
+};
+
+// Free-bay bitmap for one zone (floor): one bit per free bay, and above it one
+// bit per word with a free bay, so a search is one countr_zero per level
+struct BayZone {
+    string name;                        // Display name, e.g. "Level 1"
+    int firstBay  = 0;                  // Lot-wide number of the zone's first bay
+    int bayCount  = 0;                  // Bays in this zone
+    int freeCount = 0;                  // Bays currently free
+    vector<vector<uint64_t>> levels;    // levels[0] = bays, levels.back() = one summary word
+
+    void init(string zoneName, int first, int count);
+    int  allocate();                    // Returns a zone-local bay, -1 if full
+    void claim(int bay);                // Marks a specific bay as taken
+    void release(int bay);
+};
+
+// Bay allocator for the whole lot, one bitmap per zone
+struct BayAllocator {
+    vector<BayZone> zones;
+    int totalBays = 0;
+    int freeBays  = 0;
+
+    void init(int zoneCount, int baysPerZone);
+    int  allocate();                    // Returns a lot-wide bay number, -1 if full
+    void claim(int bay);
+    void release(int bay);
+    int  zoneOf(int bay) const;
+    int  occupied() const { return totalBays - freeBays; }
+};
+
+// Bounded lock-free queue for many producers and one consumer. Each cell's
+// sequence number says whose turn it is; push() waits while the ring is full.
+template <typename T>
+struct EventRing {
+    struct Cell {
+        atomic<uint64_t> sequence;
+        T value;
+    };
+
+    unique_ptr<Cell[]> cells;
+    size_t mask;
+    alignas(64) atomic<uint64_t> head{0};   // Next position producers claim
+    alignas(64) atomic<uint64_t> tail{0};   // Next position the consumer takes
+    atomic<uint64_t> stalls{0};             // Pushes that found the ring full
+
+    // Capacity must be a power of two
+    explicit EventRing(size_t capacity) : cells(new Cell[capacity]), mask(capacity - 1) {
+        for (size_t i = 0; i < capacity; ++i) cells[i].sequence.store(i, memory_order_relaxed);
+    }
+
+    bool tryPush(const T &value) {
+        uint64_t position = head.load(memory_order_relaxed);
+        while (true) {
+            Cell &cell = cells[position & mask];
+            // Acquire pairs with the consumer's release, so its read of the old value is done
+            int64_t lag = (int64_t)(cell.sequence.load(memory_order_acquire) - position);
+            if (lag == 0) {
+                // The CAS only claims the position; the cell is published by its sequence
+                if (head.compare_exchange_weak(position, position + 1, memory_order_relaxed)) {
+                    cell.value = value;
+                    cell.sequence.store(position + 1, memory_order_release);  // Value visible before the turn passes
+                    return true;
+                }
+            } else if (lag < 0) {
+                return false;                   // Consumer has not freed this cell yet
+            } else {
+                position = head.load(memory_order_relaxed);
+            }
+        }
+    }
+
+    void push(const T &value) {
+        if (tryPush(value)) return;
+        stalls.fetch_add(1, memory_order_relaxed);
+        while (!tryPush(value)) this_thread::yield();
+    }
+
+    // Take up to maxCount published values in order (consumer thread only)
+    size_t popBatch(T *out, size_t maxCount) {
+        uint64_t position = tail.load(memory_order_relaxed);
+        size_t taken = 0;
+        while (taken < maxCount) {
+            Cell &cell = cells[position & mask];
+            if (cell.sequence.load(memory_order_acquire) != position + 1) break;  // Pairs with the producer's release
+            out[taken++] = cell.value;
+            cell.sequence.store(position + mask + 1, memory_order_release);     // Hand the cell to the next lap's producer
+            position++;
+        }
+        tail.store(position, memory_order_release);
+        return taken;
+    }
+
+    size_t depth() const {
+        uint64_t taken = tail.load();
+        return (size_t)(head.load() - taken);
+    }
+};
+
+struct Journal;
+
+// A lot's tariff; every amount is in centavos. Tariff<RATES> and PricingTable
+// turn it into a per-minute price table.
+struct TariffRates {
+    int64_t ratePerHour;        // Standard rate per hour
+    int64_t overtimeRate;       // Rate per hour after standardMinutes
+    int64_t standardMinutes;    // Minutes billed at the standard rate
+    int64_t overnightFee;       // Added when the vehicle stayed overnight
+    int64_t lostCardFee;        // Added when the parking card was lost
+};
+
+// Fee for an m-minute stay before surcharges, prorated by the minute and
+// rounded to the nearest centavo. Every price table is filled from this.
+constexpr int64_t tariffMinuteFee(const TariffRates &rates, int64_t m) {
+    int64_t standard = min(m, rates.standardMinutes);
+    return (standard * rates.ratePerHour + (m - standard) * rates.overtimeRate + 30) / 60;
+}
+
+// Per-minute price table for a lot's tariff, built by the compiler. Entry m
+// is the fee for an m-minute stay; each whole day past the table adds DAY_FEE.
+template <TariffRates RATES>
+struct Tariff {
+    static constexpr TariffRates rates = RATES;
+    static constexpr int64_t TABLE_MINUTES = RATES.standardMinutes + 1440;
+    static constexpr int64_t DAY_FEE = 24 * RATES.overtimeRate;     // 24 hours of overtime
+
+    static constexpr array<int64_t, TABLE_MINUTES> table = [] {
+        array<int64_t, TABLE_MINUTES> fees = {};
+        for (int64_t m = 0; m < TABLE_MINUTES; ++m) fees[m] = tariffMinuteFee(RATES, m);
+        return fees;
+    }();
+
+    static constexpr int64_t price(int64_t minutes, bool overnight, bool lostCard) {
+        minutes = max<int64_t>(minutes, 0);
+        int64_t extraDays = max<int64_t>(minutes - RATES.standardMinutes, 0) / 1440;   // 0 inside the table
+        return table[minutes - extraDays * 1440] + extraDays * DAY_FEE
+             + (overnight ? RATES.overnightFee : 0) + (lostCard ? RATES.lostCardFee : 0);
+    }
+};
+
+// The price table exits use: a Tariff<RATES> table, or one filled at run time
+// for a rate card read from TARIFF_FILE. Never changed once published.
+struct PricingTable {
+    TariffRates     rates;
+    int64_t         dayFee;             // Price of each whole day past the table
+    int64_t         vectorMaxMinutes;   // Longest stay the AVX2 fee kernel prices exactly
+    const int64_t  *table;              // Fee for 0 .. standardMinutes + 1439 minutes
+    vector<int64_t> loadedTable;        // Holds the table for a rate card loaded at run time
+
+    explicit PricingTable(const TariffRates &tariffRates);
+    template <TariffRates RATES>
+    explicit PricingTable(Tariff<RATES>)
+        : rates(RATES), dayFee(Tariff<RATES>::DAY_FEE), vectorMaxMinutes(vectorLimit(RATES)), table(Tariff<RATES>::table.data()) {}
+    PricingTable(const PricingTable &) = delete;
+    PricingTable &operator=(const PricingTable &) = delete;
+
+    int64_t price(int64_t minutes, bool overnight, bool lostCard) const;
+
+    // Above this many minutes a stay's fee numerator could pass 32 bits
+    static constexpr int64_t vectorLimit(const TariffRates &rates) {
+        return ((int64_t(1) << 32) - 31) / max<int64_t>(1, max(rates.ratePerHour, rates.overtimeRate));
+    }
+};
+
+// Holds the tariff exits are priced with and swaps it while the lot runs
+// (RCU style): readers never lock, publish() frees a table once they are done.
+struct TariffPublisher {
+    static constexpr int READER_SLOTS = 64;
+    struct alignas(64) ReaderSlot {
+        atomic<uint32_t> readers[2] = {0, 0};
+    };
+
+    atomic<const PricingTable *> current{nullptr};
+    atomic<uint64_t> generation{0};
+    ReaderSlot       slots[READER_SLOTS];
+    mutex            publishLock;       // Serializes publishers; readers never touch it
+    atomic<uint64_t> swaps{0};          // Tariffs published since startup
+
+    TariffPublisher();
+    ~TariffPublisher() { delete current.load(); }
+    void publish(const TariffRates &rates);
+};
+
+// Read-side critical section: the table it pinned stays valid until it is destroyed
+struct TariffReader {
+    atomic<uint32_t>   &counter;
+    const PricingTable *table;
+
+    explicit TariffReader(TariffPublisher &publisher);
+    ~TariffReader() { counter.fetch_sub(1); }
+    TariffReader(const TariffReader &) = delete;
+    TariffReader &operator=(const TariffReader &) = delete;
+};
+
+// A snapshot file mapped (or, without mmap, read) into memory. Columns of the
+// session table point straight into it, so it must outlive them.
+struct MappedFile {
+    char  *data   = nullptr;
+    size_t length = 0;
+    bool   mapped = false;      // True for mmap, false for a heap copy
+
+    MappedFile() = default;
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() { release(); }
+
+    void release();
+};
+
+// Everything the parking system keeps in memory
+struct ParkingLot {
+    MappedFile   snapshot;      // Loaded snapshot, declared first so it is released last
+    SessionTable logs;          // Every parking session logged so far
+    PlateIndex   plateIndex;    // Plate lookup for currently parked vehicles
+    ActiveSet    active;        // Rows of currently parked vehicles
+    SessionIndexes indexes;     // Entry, exit and fee order for queries
+    PlateSearch  plateSearch;   // Partial plate lookup over parked and recent cars
+    BayAllocator bays;          // Free and occupied parking bays
+    LotStats     stats;         // Revenue, occupancy and stay totals
+    OccupancyTimeline occupancy; // Per-minute and per-hour occupancy history
+    TariffPublisher tariff;     // Rate card exits are priced with
+    Journal     *journal = nullptr; // Write-ahead journal, null when not persisting
+};
+
+// Outcome of a gate operation
+enum GateResult {
+    GATE_OK,
+    GATE_LOT_FULL,              // No free bay
+    GATE_BAD_PLATE,             // Plate is empty or too long
+    GATE_ALREADY_PARKED,        // Entry for a plate that is still inside
+    GATE_NOT_PARKED,            // Exit for a plate that is not inside
+    GATE_BAD_TIME,              // Time is not HH:MM or YYYY-MM-DD HH:MM
+    GATE_EXIT_BEFORE_ENTRY,     // Exit time earlier than the entry time
+    GATE_RESULT_COUNT
+};
+
+// Journal event types
+constexpr uint8_t JOURNAL_ENTRY = 1;
+constexpr uint8_t JOURNAL_EXIT  = 2;
+
+// Journal file header
+struct JournalHeader {
+    char     magic[8];          // "EPEECTJ" + NUL
+    uint32_t version;           // JOURNAL_VERSION
+    uint32_t recordSize;        // sizeof(JournalRecord)
+};
+
+// One gate event as stored in the journal
+struct JournalRecord {
+    uint32_t checksum;          // FNV-1a of the rest of the record, catches torn writes
+    uint8_t  type;              // JOURNAL_ENTRY or JOURNAL_EXIT
+    uint8_t  flags;             // SESSION_OVERNIGHT / SESSION_LOST_CARD on exits
+    uint16_t reserved;
+    uint64_t sequence;          // 1, 2, 3 ... in the order events were applied
+    int64_t  time;              // Event time (epoch minutes)
+    char     plate[PLATE_LENGTH];
+    int64_t  timeFee;           // What an exit was charged for the stay (centavos)
+    int64_t  overnightFee;      // Overnight surcharge an exit was charged
+    int64_t  lostCardFee;       // Lost card charge an exit was charged
+};
+static_assert(sizeof(JournalRecord) == 64, "journal records are fixed size");
+
+// Append-only write-ahead journal with group commit: a flusher thread writes
+// and syncs everything pending at once. Replayed into the lot at startup.
+struct Journal {
+    int    fd = -1;
+    mutex  lock;
+    condition_variable flushWanted;     // Wakes the flusher
+    condition_variable flushed;         // Wakes callers waiting for durability
+    vector<char> pending;               // Appended but not yet written
+    uint64_t lastSequence    = 0;       // Last sequence appended
+    uint64_t durableSequence = 0;       // Last sequence written and synced
+    uint64_t commits  = 0;              // Disk syncs issued
+    bool     stopping = false;
+    bool     failed   = false;          // A write or sync failed
+    int      notifyFd = -1;             // eventfd bumped after every commit (daemon mode)
+    thread   flusher;
+
+    bool     open(const string &path, ParkingLot &lot, long long &replayed);
+    bool     reset();
+    uint64_t append(uint8_t type, const PlateText &plate, int64_t time, uint8_t flags, const ExitCharge &charge = {});
+    bool     waitDurable(uint64_t sequence);
+    bool     hasFailed();
+    void     close();
+
+private:
+    void flushLoop();
+};
+
+// Snapshot columns, in file order
+enum SnapshotColumn {
+    SNAPSHOT_PLATES,
+    SNAPSHOT_ENTRY_TIMES,
+    SNAPSHOT_EXIT_TIMES,
+    SNAPSHOT_FEES,
+    SNAPSHOT_STATUSES,
+    SNAPSHOT_BAYS,
+    SNAPSHOT_ACTIVE_SLOTS,      // ActiveSet::slots, -1 for rows that have left
+    SNAPSHOT_ACTIVE_ROWS,       // ActiveSet::rows, a plain array
+    SNAPSHOT_OCCUPANCY,         // OccupancyTimeline, as-is
+    SNAPSHOT_COLUMN_COUNT
+};
+
+// Snapshot file header. Every column starts on a page boundary and is padded
+// to whole chunks, so a mapped column can be handed to ChunkedArray::adopt
+// as-is and still has room to append into its last chunk.
+struct SnapshotHeader {
+    char     magic[8];                          // "EPEECTS" + NUL
+    uint32_t version;                           // SNAPSHOT_VERSION
+    uint32_t chunkSize;                         // ChunkedArray CHUNK_SIZE the columns are padded to
+    uint64_t rowCount;                          // Sessions in the table
+    uint64_t activeCount;                       // Parked sessions
+    uint64_t journalSequence;                   // Last journal event included
+    uint32_t totalBays;                         // Bay layout the snapshot was taken with
+    uint32_t zoneCount;
+    uint64_t columnOffset[SNAPSHOT_COLUMN_COUNT];
+    uint64_t columnBytes[SNAPSHOT_COLUMN_COUNT];
+    LotStats stats;                             // Running totals as of the snapshot
+};
+
+// Columns of a columnar export, in the order each block stores them
+enum ExportColumn {
+    EXPORT_PLATES,              // Dictionary (length byte + plate each), then a varint index per row
+    EXPORT_ENTRY_TIMES,         // Zigzag varint change from the previous row's entry (first row: from 0)
+    EXPORT_EXIT_TIMES,          // Varint exit minus entry plus 1, 0 while parked
+    EXPORT_FEES,                // Varint centavos
+    EXPORT_STATUSES,            // One SESSION_* byte per row
+    EXPORT_BAYS,                // Varint bay number (0-based)
+    EXPORT_COLUMN_COUNT
+};
+
+// Columnar export file header, and the footer after the block index
+struct ExportHeader {
+    char     magic[8];                          // "EPEECTX" + NUL
+    uint32_t version;                           // EXPORT_VERSION
+    uint32_t blockRows;                         // Rows per block (the last may have fewer)
+};
+struct ExportFooter {
+    uint64_t blockCount;                        // Block offsets just before this footer
+    uint64_t rowCount;                          // Sessions in the file
+    char     magic[8];                          // "EPEECTX" + NUL, so truncation shows
+};
+
+// Start of each block of a columnar export
+struct ExportBlockHeader {
+    uint32_t rowCount;
+    uint32_t dictionarySize;                    // Distinct plates in this block
+    uint32_t columnBytes[EXPORT_COLUMN_COUNT];  // Encoded size of each column that follows, so readers can skip some
+};
+
+#ifdef EPEECT_BENCH
+// One block read back from a columnar export; only the columns asked for are filled
+struct ExportBlock {
+    size_t            rows = 0;
+    vector<PlateText> dictionary;
+    vector<PlateText> plates;
+    vector<int64_t>   entryTimes;
+    vector<int64_t>   exitTimes;                // -1 while parked
+    vector<int64_t>   fees;
+    vector<uint8_t>   statuses;
+    vector<int32_t>   bays;
+};
+#endif
+
+// One closed stay read back from a saved log report
+struct ImportedSession {
+    PlateText plate;
+    int64_t   entryTime;
+    int64_t   exitTime;
+    int64_t   fee;                              // Centavos
+};
+
+// What a log import read
+struct ImportCounts {
+    size_t    files = 0;                        // Log reports found
+    long long rows = 0;                         // Table rows read across all of them
+    long long malformed = 0;                    // Rows that could not be parsed
+};
+
+// What a re-rating report covered (amounts in centavos)
+struct RerateTotals {
+    long long sessions = 0;                     // Closed sessions re-priced
+    long long skipped  = 0;                     // Imported sessions left out; their surcharges were inferred
+    int64_t   charged  = 0;                     // What those sessions were charged
+    int64_t   rerated  = 0;                     // What the current tariff would charge
+};
+
+// Window onto the log table for the paged viewer. Unfiltered, positions are
+// table rows; filtered, `matches` lists the rows shown, in table order.
+struct LogView {
+    const ParkingLot *lot = nullptr;
+    string      plateFilter;            // Show plates containing this, if set
+    bool        parkedOnly = false;     // Show only vehicles still inside
+    SessionQuery query;                 // Show only sessions matching this
+    string      queryText;              // The query as typed, empty for none
+    bool        filtered   = false;     // Any filter is active
+    vector<int> matches;                // Rows passing the filter, ascending
+    size_t      top        = 0;         // Position of the first row on screen
+
+    size_t size() const { return filtered ? matches.size() : lot->logs.size(); }
+    size_t rowAt(size_t position) const { return filtered ? (size_t)matches[position] : position; }
+};
+
+// Report text builder. Rows are formatted straight into one large reusable
+// buffer with to_chars and the buffer goes to the file descriptor in big
+// writes, only when it fills or on flush(). A negative fd discards the
+// output, which the benchmarks use to time formatting alone.
+struct ReportWriter {
+    int          fd;
+    vector<char> buffer;
+    size_t       used = 0;
+    bool         ok   = true;       // False once a write has failed
+
+    explicit ReportWriter(int fd, size_t capacity = 1 << 20) : fd(fd), buffer(capacity) {}
+
+    void append(string_view text);
+    void appendPadded(string_view text, int width);     // Left-justified, like left << setw
+    void appendNumber(long long value);
+    void appendNumberPadded(long long value, int width);
+    void appendTimePadded(int64_t time, int width);
+    void appendFeePadded(int64_t centavos, int width);
+    void appendCentered(string_view text, int width);    // Same layout as printCentered
+    bool flush();
+
+private:
+    char *reserve(size_t bytes);
 };
 
 constexpr int   TOTAL_SPACES    = 100;              // Total parking spaces
-constexpr int   MAX_LOGS        = 100;              // Maximum number of parking logs
-constexpr float RATE_PER_HOUR   = 20.0f;            // Standard rate per hour
-constexpr float OVERTIME_RATE   = 30.0f;            // Overtime parking rate
-constexpr float OVERNIGHT_RATE  = 200.0f;           // Overnight parking rate
-constexpr float LOST_CARD_FEE   = 200.0f;           // Lost card compensation fee
+constexpr size_t LOG_PAGE_ROWS  = 20;               // Rows per page in the log viewer
+constexpr size_t PLATE_SEARCH_RECENT = 4096;        // Exited plates kept searchable
+constexpr size_t PLATE_SEARCH_LIMIT  = 10;          // Candidates shown for a plate search
+constexpr int   PARKING_ZONES   = 2;                // Floors the spaces are split across
+constexpr TariffRates STANDARD_TARIFF = {          // P20/hour for 3 hours, P30/hour after,
+    2000, 3000, 180, 20000, 20000                   // P200 overnight, P200 lost card
+};
+using StandardTariff = Tariff<STANDARD_TARIFF>;      // Built-in rate card, priced from a compile-time table
+static_assert(StandardTariff::price(60, false, false) == 2000
+              && StandardTariff::price(240, true, true) == 6000 + 3000 + 40000
+              && StandardTariff::price(180 + 1440 * 3 + 1, false, false) == 6000 + 3 * StandardTariff::DAY_FEE + 50
+              && tariffMinuteFee(STANDARD_TARIFF, 180 + 1440 + 1) == tariffMinuteFee(STANDARD_TARIFF, 181) + StandardTariff::DAY_FEE,
+              "tariff table matches the rate card");
+constexpr const char *TARIFF_FILE = "tariff.conf"; // Optional rate card, reloaded when it changes
+constexpr int     TIMESTAMP_LENGTH = 16;           // "YYYY-MM-DD HH:MM"
+constexpr int64_t DWELL_LIMITS[LotStats::DWELL_BUCKETS - 1] = { // Upper bound (minutes) of each
+    60, 120, 180, 360, 720, 1440, 2880              // stay-length class but the last
+};
+constexpr uint32_t JOURNAL_VERSION = 1;             // Journal file format version
+constexpr const char *JOURNAL_FILE = "parking.journal"; // Write-ahead journal next to the log files
+constexpr uint32_t SNAPSHOT_VERSION = 1;            // Snapshot file format version
+constexpr const char *SNAPSHOT_FILE = "parking.snapshot"; // Session table snapshot taken at shutdown
+constexpr size_t SNAPSHOT_ALIGN = 4096;             // Column alignment inside the snapshot
+constexpr int    GATE_THREADS = 4;                  // Socket threads in daemon mode
+constexpr size_t GATE_QUEUE_CAPACITY = 4096;        // Requests queued between gate threads and the ledger
+constexpr uint32_t EXPORT_VERSION = 1;              // Columnar export format version
+constexpr size_t EXPORT_BLOCK_ROWS = 65536;         // Sessions per columnar export block
+constexpr size_t LEDGER_BATCH = 256;                // Requests the ledger applies per drain
+constexpr const char *JOURNAL_FAILED_REPLY = "ERR JOURNAL Could not save to disk, the event may not be recorded."; // Daemon reply once the journal fails
 
 //+==========================================+
 //           FUNCTION DECLARATIONS
 //+==========================================+
 // HELPER FUNCTION DECLARATIONS
-bool isValidTime(const string &time);                                                          // Declares the function to validate time format
-float timeToHours(string time);                                                                // Declares the function to convert time to hours
-float calculateParkingFee(float duration, float RATE_PER_HOUR, float OVERTIME_RATE, float overnightRate, float lostCardFee); // Declares the function to calculate parking fee
-int  findVehicle(ParkingLog logs[], int logCount, string plate);                               // Declares the function to find vehicle by license plate
-void printLogHeader(ostream &out);                                                             // Declares the function to print log header to file
+int64_t daysFromCivil(int year, int month, int day);                                           // Declares the function to count days since 1970-01-01
+void civilFromDays(int64_t days, int &year, int &month, int &day);                             // Declares the function to turn a day count into a date
+int64_t currentDayStart();                                                                     // Declares the function to get today's midnight in epoch minutes
+int64_t currentMinute();                                                                       // Declares the function to get the wall clock in epoch minutes
+bool parseTimestamp(string_view text, int64_t notBefore, int64_t &time);                       // Declares the function to parse a gate time
+char *writeTimestamp(char *out, int64_t time);                                                 // Declares the function to write a time as YYYY-MM-DD HH:MM
+string formatTime(int64_t time);                                                               // Declares the function to format a time as YYYY-MM-DD HH:MM
+string formatBay(const BayAllocator &bays, int bay);                                           // Declares the function to format a bay number
+int64_t calculateParkingFee(const PricingTable &tariff, int64_t minutes, bool overnight, bool lostCard); // Declares the function to calculate parking fee
+void calculateParkingFees(const PricingTable &tariff, const int64_t *minutes, const uint8_t *flags, int64_t *fees, size_t count); // Declares the function to price many stays at once
+bool loadTariff(const string &path, TariffRates &rates, string &error);                        // Declares the function to read a rate card file
+bool reloadTariff(TariffPublisher &tariff, const string &path, filesystem::file_time_type &stamp); // Declares the function to publish a changed rate card
+bool normalizePlate(string_view text, PlateText &plate);                                        // Declares the function to turn a typed plate into a stored one
+uint32_t hashPlate(const PlateText &plate);                                                    // Declares the function to hash a license plate
+int  findVehicle(const PlateIndex &plateIndex, const SessionTable &logs, const PlateText &plate); // Declares the function to find a parked vehicle by license plate
+void writeLogHeader(ReportWriter &out);                                                        // Declares the function to write the log table header
 string formatExitTime(const ParkingLog &log);                                                  // Declares the function to format exit time
+string formatPesos(int64_t centavos);                                                           // Declares the function to format an amount in pesos
 string formatFee(const ParkingLog &log);                                                       // Declares the function to format fee
+void writeLogRows(ReportWriter &out, const SessionTable &logs);                                // Declares the function to write every log row
+void writeLogReport(ReportWriter &out, const SessionTable &logs);                              // Declares the function to write the titled log table
+void writeStatsReport(ReportWriter &out, const LotStats &stats);                               // Declares the function to write the statistics summary
+void writeOccupancyReport(ReportWriter &out, const OccupancyTimeline &occupancy, int64_t now); // Declares the function to write the occupancy summary
+bool writeLogReport(const SessionTable &logs, const LotStats &stats, const string &filename);  // Declares the function to write the log report to a file
+vector<int> parkedRowsInArrivalOrder(const ActiveSet &active);                                 // Declares the function to list parked rows in arrival order
 void clearScreen();                                                                            // Declares the function to clear the console screen
 void pauseProgram();                                                                           // Declares the function to pause the program     
 void printCentered(ostream &out, string text, int width = 45);                                 // Declares the function to print centered text    
+// GATE OPERATION DECLARATIONS
+GateResult recordEntry(ParkingLot &lot, string_view plate, int64_t entryTime, int &row);      // Declares the function to park a vehicle
+ExitCharge priceExit(const PricingTable &tariff, int64_t minutes, bool lostCard, bool overnight); // Declares the function to price a stay
+void closeSession(SessionTable &logs, LotStats &stats, int row, int64_t exitTime, uint8_t flags, const ExitCharge &charge); // Declares the function to close a session with its charge
+GateResult recordExit(ParkingLot &lot, int row, int64_t exitTime, bool lostCard, bool overnight); // Declares the function to check out a parked vehicle
+GateResult settleExit(ParkingLot &lot, int row, int64_t exitTime, uint8_t flags, const ExitCharge &charge); // Declares the function to check out a vehicle at a known charge
+const char *gateResultMessage(GateResult result);                                              // Declares the function to describe a gate result
+bool awaitDurable(ParkingLot &lot);                                                            // Declares the function to wait until every applied event is on disk
+uint32_t journalChecksum(const JournalRecord &record);                                          // Declares the function to checksum a journal record
+bool writeAll(int fd, const char *data, size_t size);                                          // Declares the function to write a whole buffer to a file
+bool saveSnapshot(const ParkingLot &lot, const string &path, uint64_t journalSequence);        // Declares the function to write a session table snapshot
+bool loadSnapshot(ParkingLot &lot, const string &path, uint64_t &journalSequence);             // Declares the function to map a session table snapshot
+bool checkpoint(ParkingLot &lot);                                                              // Declares the function to snapshot the lot and empty the journal
+bool syncFile(int fd);                                                                         // Declares the function to flush a file to disk
+int  splitEventFields(string_view line, string_view fields[], int maxFields);                   // Declares the function to split a batch event line
+bool isYes(string_view answer);                                                                // Declares the function to read a Y/N answer
+int  runBatch(ParkingLot &lot, const string &path);                                            // Declares the function to replay gate events without prompts
+bool exportColumnar(const SessionTable &logs, const string &path);                             // Declares the function to write the columnar analytics export
+bool exportCsv(const SessionTable &logs, const string &path);                                  // Declares the function to write every session as CSV
+int  runExport(const SessionTable &logs, const string &columnarPath, const string &csvPath);   // Declares the function to write the exports asked for
+RerateTotals rerateSessions(const SessionTable &logs, const PricingTable &tariff, ReportWriter &out); // Declares the function to re-price closed sessions into a report
+int  runRerate(ParkingLot &lot, const string &path);                                           // Declares the function to write the re-rating report from the command line
+vector<string> findLogFiles(const string &directory);                                          // Declares the function to list saved log reports
+long long importLogFiles(ParkingLot &lot, const string &directory, ImportCounts &counts);       // Declares the function to merge saved log reports into the table
+int  runImport(ParkingLot &lot, const string &directory);                                      // Declares the function to import saved log reports
+string handleGateRequest(ParkingLot &lot, string_view line);                                   // Declares the function to answer one gate request line
+int  runDaemon(ParkingLot &lot, const string &socketPath, int gateThreads, filesystem::file_time_type &tariffStamp); // Declares the function to serve gates over a local socket
+#ifdef EPEECT_BENCH
+int  runBenchmarks(int argc, char *argv[]);                                                    // Declares the function to run the benchmark suite
+#endif
 // MAIN FUNCTION DECLARATIONS
-void printMenu(int TOTAL_SPACES, int occupiedSpaces);                                          // Declares the function to print the menu                                                                         
-void vehicleEntry(ParkingLog logs[], int &occupiedSpaces, int TOTAL_SPACES, int &logCount);    // Declares the function for vehicle entry
-void vehicleExit(ParkingLog logs[], int &occupiedSpaces, int TOTAL_SPACES, int &logCount);     // Declares the function for vehicle exit
-void viewLogs(ParkingLog logs[], int logCount);                                                // Declares the function to view parking logs
-void saveLogsToFile(ParkingLog logs[], int logCount);                                          // Declares the function to save logs to a file        
+void printMenu(const BayAllocator &bays);                                                      // Declares the function to print the menu                                                                         
+void vehicleEntry(ParkingLot &lot);                                                            // Declares the function for vehicle entry
+void vehicleExit(ParkingLot &lot);                                                             // Declares the function for vehicle exit
+void viewLogs(const ParkingLot &lot);                                                          // Declares the function to view parking logs
+void writeLogPage(ReportWriter &out, const LogView &view, size_t pageRows);                    // Declares the function to write one page of the log viewer
+void filterLogView(LogView &view);                                                             // Declares the function to apply the log viewer's filter
+void rebuildIndexes(ParkingLot &lot, bool feesOnly = false);                                   // Declares the function to rebuild the secondary indexes
+bool parseSessionQuery(string_view text, int64_t today, SessionQuery &query);                  // Declares the function to parse a session query
+vector<int> runSessionQuery(const ParkingLot &lot, const SessionQuery &query);                 // Declares the function to find the sessions matching a query
+void rebuildPlateSearch(ParkingLot &lot);                                                      // Declares the function to rebuild the plate search index
+vector<PlateMatch> searchPlates(const ParkingLot &lot, string_view text, bool parkedOnly, size_t limit); // Declares the function to find plates matching partial text
+const char *plateMatchLabel(PlateMatchKind kind);                                              // Declares the function to describe a plate match
+void viewStats(const ParkingLot &lot);                                                         // Declares the function to view lot statistics
+void saveLogsToFile(const SessionTable &logs, const LotStats &stats);                          // Declares the function to save logs to a file        
 
 //+==========================================+
 //               MAIN FUNCTION
 //+==========================================+
 
-int main() {
-    int occupiedSpaces = 0;     // Current occupied parking spaces
-    ParkingLog logs[MAX_LOGS];  // Array to store parking logs
-    int logCount = 0;           // Current number of logs
-    int choice = 0;             // User menu choice
+int main(int argc, char *argv[]) {
+    ParkingLot lot;             // Sessions, indexes and bays
+    int choice = 0;             // User menu choice
+
+#ifdef EPEECT_BENCH
+    return runBenchmarks(argc, argv);
+#endif
+
+    lot.bays.init(PARKING_ZONES, TOTAL_SPACES / PARKING_ZONES);
+
+    // Options: --batch [events.txt] runs headless (stdin without a file),
+    // --daemon [parking.sock] serves gates over a local socket (--gates N
+    // sets its socket threads), --no-journal keeps everything in memory only,
+    // --import [directory] first merges in the sessions from saved
+    // ParkingLogs_*.txt reports, --export <file> and --csv <file> write the
+    // sessions out for analysis and --rerate [rerate.csv] writes what every
+    // closed session would cost under the current tariff (after the batch or
+    // daemon when given with one, otherwise on their own)
+    bool batchMode = false, daemonMode = false, useJournal = true, importMode = false, rerateMode = false;
+    string batchPath = "-", socketPath = "parking.sock", importPath = ".", exportPath, csvPath, reratePath = "rerate.csv";
+    int gateThreads = GATE_THREADS;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--batch") {
+            batchMode = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') batchPath = argv[++i];
+        } else if (arg == "--daemon") {
+            daemonMode = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') socketPath = argv[++i];
+        } else if (arg == "--gates" && i + 1 < argc) {
+            gateThreads = atoi(argv[++i]);
+        } else if (arg == "--no-journal") {
+            useJournal = false;
+        } else if (arg == "--import") {
+            importMode = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') importPath = argv[++i];
+        } else if (arg == "--rerate") {
+            rerateMode = true;
+            if (i + 1 < argc && argv[i + 1][0] != '-') reratePath = argv[++i];
+        } else if (arg == "--export" && i + 1 < argc) {
+            exportPath = argv[++i];
+        } else if (arg == "--csv" && i + 1 < argc) {
+            csvPath = argv[++i];
+        }
+    }
+
+    // Rebuild state from the last snapshot plus the journal written since
+    Journal journal;
+    #ifdef __linux__
+        // The daemon takes SIGINT/SIGTERM/SIGHUP through a signalfd; block them
+        // before the journal flusher starts so that thread inherits the mask too
+        if (daemonMode) {
+            sigset_t signals;
+            sigemptyset(&signals);
+            sigaddset(&signals, SIGINT);
+            sigaddset(&signals, SIGTERM);
+            sigaddset(&signals, SIGHUP);
+            pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+        }
+    #endif
+
+    // Use the rate card in TARIFF_FILE when there is one
+    filesystem::file_time_type tariffStamp;
+    if (reloadTariff(lot.tariff, TARIFF_FILE, tariffStamp) && (batchMode || daemonMode)) {
+        cout << "Loaded tariff from '" << TARIFF_FILE << "'.\n";
+    }
+
+    if (useJournal) {
+        auto start = chrono::steady_clock::now();
+        bool loaded = loadSnapshot(lot, SNAPSHOT_FILE, journal.lastSequence);
+        double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        error_code missing;
+        if (!loaded && filesystem::exists(SNAPSHOT_FILE, missing)) {
+            // Going on would checkpoint an empty lot over it
+            cerr << "Error: Could not load snapshot '" << SNAPSHOT_FILE << "'. Move it aside to start without it.\n";
+            return 1;
+        }
+        if ((batchMode || daemonMode) && loaded) {
+            cout << "Loaded " << lot.logs.size() << " sessions from '" << SNAPSHOT_FILE << "' in "
+                 << fixed << setprecision(1) << milliseconds << " ms.\n";
+        }
+
+        long long replayed = 0;
+        if (!journal.open(JOURNAL_FILE, lot, replayed)) {
+            cerr << "Error: Could not open journal '" << JOURNAL_FILE << "'.\n";
+            return 1;
+        }
+        lot.journal = &journal;
+        if ((batchMode || daemonMode) && replayed > 0) cout << "Recovered " << replayed << " events from '" << JOURNAL_FILE << "'.\n";
+    }
+
+    bool exportMode = !exportPath.empty() || !csvPath.empty();
+    if (batchMode || daemonMode || importMode || rerateMode || exportMode) {
+        int status = importMode ? runImport(lot, importPath) : 0;
+        if (status == 0 && (batchMode || daemonMode)) {
+            status = batchMode ? runBatch(lot, batchPath) : runDaemon(lot, socketPath, gateThreads, tariffStamp);
+        }
+        if (status == 0 && exportMode) status = runExport(lot.logs, exportPath, csvPath);
+        if (status == 0 && rerateMode) status = runRerate(lot, reratePath);
+        if (lot.journal && !checkpoint(lot)) cerr << "Error: Could not write snapshot '" << SNAPSHOT_FILE << "'.\n";
+        journal.close();
+        return status;
+    }
+
+    // Main program loop
+    while (choice != 5) {
+        clearScreen();
+        reloadTariff(lot.tariff, TARIFF_FILE, tariffStamp);     // Pick up an edited rate card
+        printMenu(lot.bays);
+        cin >> choice;
+        cin.ignore(numeric_limits<streamsize>::max(), '\n');
+        
+        // Validate input
+        if (cin.fail()) {
+            cin.clear();
+            cin.ignore(numeric_limits<streamsize>::max(), '\n');
+            cout << "\nInvalid input! Please enter a number (1-5).\n";
+            pauseProgram();
+            continue;
+        }
+
+        // Handle user choice
+        switch (choice) {
+            case 1: vehicleEntry(lot); pauseProgram(); break;                                             // Vehicle Entry
+            case 2: vehicleExit(lot); pauseProgram(); break;                                              // Vehicle Exit
+            case 3: viewLogs(lot); break;                                                                 // View Parking Logs
+            case 4: viewStats(lot); pauseProgram(); break;                                                // View Statistics
+            case 5:                                                                                       // Exit Program
+                saveLogsToFile(lot.logs, lot.stats);
+                if (lot.journal && !checkpoint(lot)) cout << "Error: Could not write snapshot '" << SNAPSHOT_FILE << "'.\n";
+                journal.close();
+                cout << "Exiting the program. Goodbye!\n";
+                return 0;
+            default: cout << "Invalid choice. Please try again.\n"; pauseProgram(); break;              // Invalid Choice
+        }
+    }
+
+    return 0;
+}
+//+==========================================+
+//       HELPER FUNCTIONS DEFINITIONS
+//+==========================================+
+
+// Clear console screen
+void clearScreen() {
+    #ifdef _WIN32
+        system("cls");
+    #else
+        if (system("clear") != 0) {
+            cout << "\033[2J\033[1;H";
+        }
+    #endif
+}
+
+// Pause program until Enter is pressed
+void pauseProgram() {
+    cout << "\nPress Enter to continue...";
+    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+}
+
+// Days from 1970-01-01 to a proleptic Gregorian date (Howard Hinnant's algorithm)
+int64_t daysFromCivil(int year, int month, int day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    int64_t yearOfEra = year - era * 400;
+    int64_t dayOfYear = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    int64_t dayOfEra = yearOfEra * 365 + yearOfEra / 4 - yearOfEra / 100 + dayOfYear;
+    return era * 146097 + dayOfEra - 719468;
+}
+
+// Date of a day counted from 1970-01-01, the inverse of daysFromCivil
+void civilFromDays(int64_t days, int &year, int &month, int &day) {
+    days += 719468;
+    int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+    int64_t dayOfEra = days - era * 146097;
+    int64_t yearOfEra = (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+    int64_t dayOfYear = dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+    int64_t monthIndex = (5 * dayOfYear + 2) / 153;
+    day = (int)(dayOfYear - (153 * monthIndex + 2) / 5 + 1);
+    month = (int)(monthIndex < 10 ? monthIndex + 3 : monthIndex - 9);
+    year = (int)(yearOfEra + era * 400 + (month <= 2));
+}
+
+// Today's midnight on the local wall clock, in epoch minutes
+int64_t currentDayStart() {
+    time_t now = time(nullptr);
+    tm local = *localtime(&now);
+    return daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) * 1440;
+}
+
+// The current minute on the local wall clock, in epoch minutes
+int64_t currentMinute() {
+    time_t now = time(nullptr);
+    tm local = *localtime(&now);
+    return daysFromCivil(local.tm_year + 1900, local.tm_mon + 1, local.tm_mday) * 1440 + local.tm_hour * 60 + local.tm_min;
+}
+
+// Read exactly `count` digits at `text` as a number, -1 if any is not a digit
+static int parseDigits(const char *text, int count) {
+    int value = 0;
+    for (int i = 0; i < count; ++i) {
+        unsigned digit = (unsigned char)text[i] - '0';
+        if (digit > 9) return -1;
+        value = value * 10 + (int)digit;
+    }
+    return value;
+}
+
+// Parse a gate time without allocating. "YYYY-MM-DD HH:MM" is taken as is;
+// a bare "HH:MM" means the first such time at or after `notBefore` (today's
+// midnight for entries, the entry time for exits, so an exit earlier in the
+// day than its entry lands on the next day)
+bool parseTimestamp(string_view text, int64_t notBefore, int64_t &time) {
+    if (text.size() != 5 && text.size() != TIMESTAMP_LENGTH) return false;
+    const char *clock = text.data() + text.size() - 5;
+    int hours = parseDigits(clock, 2), minutes = parseDigits(clock + 3, 2);
+    if (clock[2] != ':' || hours < 0 || hours > 23 || minutes < 0 || minutes > 59) return false;
+    int64_t minuteOfDay = hours * 60 + minutes;
+
+    if (text.size() == 5) {
+        int64_t dayStart = notBefore - ((notBefore % 1440) + 1440) % 1440;
+        time = dayStart + minuteOfDay;
+        if (time < notBefore) time += 1440;
+        return true;
+    }
+
+    int year = parseDigits(text.data(), 4), month = parseDigits(text.data() + 5, 2), day = parseDigits(text.data() + 8, 2);
+    if (text[4] != '-' || text[7] != '-' || (text[10] != ' ' && text[10] != 'T')) return false;
+    if (year < 1970 || month < 1 || month > 12 || day < 1) return false;
+    int64_t days = daysFromCivil(year, month, day);
+    int checkYear, checkMonth, checkDay;
+    civilFromDays(days, checkYear, checkMonth, checkDay);
+    if (checkMonth != month) return false; // Day past the end of the month
+    time = days * 1440 + minuteOfDay;
+    return true;
+}
+
+// Write a time as "YYYY-MM-DD HH:MM" (TIMESTAMP_LENGTH chars), return the end
+char *writeTimestamp(char *out, int64_t time) {
+    int64_t days = time / 1440, minuteOfDay = time % 1440;
+    if (minuteOfDay < 0) { minuteOfDay += 1440; days--; }
+    int year, month, day;
+    civilFromDays(days, year, month, day);
+    int hours = (int)(minuteOfDay / 60), minutes = (int)(minuteOfDay % 60);
+    const int fields[5] = {year / 100, year % 100, month, day, hours};
+    const char separators[5] = {0, 0, '-', '-', ' '};
+    for (int f = 0; f < 5; ++f) {
+        if (separators[f]) *out++ = separators[f];
+        *out++ = char('0' + fields[f] / 10);
+        *out++ = char('0' + fields[f] % 10);
+    }
+    *out++ = ':';
+    *out++ = char('0' + minutes / 10);
+    *out++ = char('0' + minutes % 10);
+    return out;
+}
+
+// Format a time as "YYYY-MM-DD HH:MM"
+string formatTime(int64_t time) {
+    char buffer[TIMESTAMP_LENGTH];
+    return string(buffer, writeTimestamp(buffer, time));
+}
+
+// Calculate the parking fee in centavos for a stay of `minutes`
+int64_t calculateParkingFee(const PricingTable &tariff, int64_t minutes, bool overnight, bool lostCard) {
+    return tariff.price(minutes, overnight, lostCard);
+}
+
+// Turn a plate as typed or read into the stored form: upper case with the
+// spaces taken out, so "abc 123" and "ABC123" are the same car. False if
+// nothing is left or it is longer than PLATE_LENGTH.
+bool normalizePlate(string_view text, PlateText &plate) {
+    plate = PlateText();
+    size_t length = 0;
+    for (char c : text) {
+        if (c == ' ' || c == '\t') continue;
+        if (length == PLATE_LENGTH) return false;
+        plate.text[length++] = (char)toupper((unsigned char)c);
+    }
+    return length > 0;
+}
+
+// Hash a license plate from its two 8-byte halves. Each multiply carries
+// every bit upward, so the top bits depend on the whole plate. Never
+// returns 0 so 0 can mark empty slots.
+uint32_t hashPlate(const PlateText &plate) {
+    uint64_t low, high;
+    memcpy(&low, plate.text, 8);
+    memcpy(&high, plate.text + 8, 8);
+    uint64_t h = (low * 0x9E3779B97F4A7C15ull ^ high) * 0xC2B2AE3D27D4EB4Full;
+    return uint32_t(h >> 32) | 1u;
+}
+
+// Find the log index of a parked vehicle by license plate
+int findVehicle(const PlateIndex &plateIndex, const SessionTable &logs, const PlateText &plate) {
+    return plateIndex.find(plate, logs); // -1 if not parked
+}
+
+// Home slot of a hash. Fibonacci hashing: the top bits of the product mix
+// every bit of the hash, where the low bits would only see its low bits.
+size_t PlateIndex::homeOf(uint32_t hash) const {
+    return uint32_t(hash * 2654435769u) >> (32 - countr_zero(slots.size()));
+}
+
+// Look up the active session for a plate
+int PlateIndex::find(const PlateText &plate, const SessionTable &logs) const {
+    uint32_t hash = hashPlate(plate);
+    size_t mask = slots.size() - 1;
+    for (size_t i = homeOf(hash); ; i = (i + 1) & mask) {
+        const Slot &slot = slots[i];
+        if (slot.hash == 0) return -1;
+        if (slot.hash == hash && logs.plates[slot.row] == plate) return slot.row;
+    }
+}
+
+// Add an active session, the caller makes sure the plate is not indexed yet
+void PlateIndex::insert(const PlateText &plate, int row) {
+    if ((count + 1) * 2 > (int)slots.size()) grow();
+    uint32_t hash = hashPlate(plate);
+    size_t mask = slots.size() - 1;
+    size_t i = homeOf(hash);
+    while (slots[i].hash != 0) i = (i + 1) & mask;
+    slots[i] = {hash, row};
+    count++;
+}
+
+// Remove an active session and shift its probe chain back into the hole
+void PlateIndex::erase(const PlateText &plate, const SessionTable &logs) {
+    uint32_t hash = hashPlate(plate);
+    size_t mask = slots.size() - 1;
+    size_t hole = homeOf(hash);
+    while (true) {
+        const Slot &slot = slots[hole];
+        if (slot.hash == 0) return; // Not indexed
+        if (slot.hash == hash && logs.plates[slot.row] == plate) break;
+        hole = (hole + 1) & mask;
+    }
+    for (size_t next = (hole + 1) & mask; slots[next].hash != 0; next = (next + 1) & mask) {
+        size_t home = homeOf(slots[next].hash);
+        // Move the entry back only if the hole lies on its probe path
+        if (((next - home) & mask) >= ((next - hole) & mask)) {
+            slots[hole] = slots[next];
+            hole = next;
+        }
+    }
+    slots[hole] = Slot();
+    count--;
+}
+
+// Double the table and re-place every entry
+void PlateIndex::grow() {
+    vector<Slot> old(slots.size() * 2);
+    old.swap(slots);
+    size_t mask = slots.size() - 1;
+    for (const Slot &slot : old) {
+        if (slot.hash == 0) continue;
+        size_t i = homeOf(slot.hash);
+        while (slots[i].hash != 0) i = (i + 1) & mask;
+        slots[i] = slot;
+    }
+}
+
+// Append a parked session and return its row
+int SessionTable::append(const PlateText &plate, int64_t entryTime, int32_t bay) {
+    plates.push_back(plate);
+    entryTimes.push_back(entryTime);
+    exitTimes.push_back(-1);
+    fees.push_back(0);
+    statuses.push_back(SESSION_PARKED);
+    bays.push_back(bay);
+    return (int)size() - 1;
+}
+
+// Gather one session from the columns
+ParkingLog SessionTable::row(size_t i) const {
+    return {plates[i], entryTimes[i], exitTimes[i], fees[i], statuses[i], bays[i]};
+}
+
+// Build the bitmap levels for a zone with every bay free
+void BayZone::init(string zoneName, int first, int count) {
+    name = zoneName;
+    firstBay = first;
+    bayCount = count;
+    freeCount = count;
+    levels.clear();
+    size_t bits = count;
+    do {
+        vector<uint64_t> level((bits + 63) / 64, 0);
+        for (size_t i = 0; i < bits; ++i) level[i / 64] |= uint64_t(1) << (i % 64);
+        bits = level.size();
+        levels.push_back(move(level));
+    } while (bits > 1);
+}
+
+// Take the lowest-numbered free bay in the zone
+int BayZone::allocate() {
+    if (freeCount == 0) return -1;
+    size_t index = 0;
+    for (size_t l = levels.size(); l-- > 0; ) {
+        index = index * 64 + countr_zero(levels[l][index]);
+    }
+    // Clear the bay's bit, and each summary bit whose word just emptied
+    size_t bit = index;
+    for (size_t l = 0; l < levels.size(); ++l) {
+        uint64_t &word = levels[l][bit / 64];
+        word &= ~(uint64_t(1) << (bit % 64));
+        if (word != 0) break;
+        bit /= 64;
+    }
+    freeCount--;
+    return (int)index;
+}
+
+// Take a specific bay, used when restoring parked vehicles
+void BayZone::claim(int bay) {
+    size_t bit = bay;
+    if (!(levels[0][bit / 64] & (uint64_t(1) << (bit % 64)))) return; // Already taken
+    for (size_t l = 0; l < levels.size(); ++l) {
+        uint64_t &word = levels[l][bit / 64];
+        word &= ~(uint64_t(1) << (bit % 64));
+        if (word != 0) break;
+        bit /= 64;
+    }
+    freeCount--;
+}
+
+// Return a bay to the zone
+void BayZone::release(int bay) {
+    size_t bit = bay;
+    if (levels[0][bit / 64] & (uint64_t(1) << (bit % 64))) return; // Already free
+    for (size_t l = 0; l < levels.size(); ++l) {
+        uint64_t &word = levels[l][bit / 64];
+        bool wasEmpty = (word == 0);
+        word |= uint64_t(1) << (bit % 64);
+        if (!wasEmpty) break;
+        bit /= 64;
+    }
+    freeCount++;
+}
+
+// Split the lot into equally sized zones
+void BayAllocator::init(int zoneCount, int baysPerZone) {
+    zones.assign(zoneCount, BayZone());
+    for (int z = 0; z < zoneCount; ++z) {
+        zones[z].init("Level " + to_string(z + 1), z * baysPerZone, baysPerZone);
+    }
+    totalBays = zoneCount * baysPerZone;
+    freeBays = totalBays;
+}
+
+// Take the first free bay, filling lower zones first
+int BayAllocator::allocate() {
+    for (BayZone &zone : zones) {
+        if (zone.freeCount == 0) continue;
+        freeBays--;
+        return zone.firstBay + zone.allocate();
+    }
+    return -1;
+}
+
+// Take a specific lot-wide bay
+void BayAllocator::claim(int bay) {
+    BayZone &zone = zones[zoneOf(bay)];
+    int before = zone.freeCount;
+    zone.claim(bay - zone.firstBay);
+    freeBays -= before - zone.freeCount;
+}
+
+// Return a lot-wide bay number to its zone
+void BayAllocator::release(int bay) {
+    BayZone &zone = zones[zoneOf(bay)];
+    int before = zone.freeCount;
+    zone.release(bay - zone.firstBay);
+    freeBays += zone.freeCount - before;
+}
+
+// Zone that holds a lot-wide bay number
+int BayAllocator::zoneOf(int bay) const {
+    int z = (int)zones.size() - 1;
+    while (z > 0 && zones[z].firstBay > bay) z--;
+    return z;
+}
+
+// Add a parked row to the set
+void ActiveSet::insert(int row) {
+    while ((int)slots.size() <= row) slots.push_back(-1);
+    slots[row] = (int32_t)rows.size();
+    rows.push_back(row);
+}
+
+// Remove a row by moving the last parked row into its place
+void ActiveSet::erase(int row) {
+    int32_t slot = slots[row];
+    if (slot < 0) return; // Not parked
+    int last = rows.back();
+    rows[slot] = last;
+    slots[last] = slot;
+    rows.pop_back();
+    slots[row] = -1;
+}
+
+// List parked rows in arrival order, touching only the active rows
+vector<int> parkedRowsInArrivalOrder(const ActiveSet &active) {
+    vector<int> rows = active.rows;
+    sort(rows.begin(), rows.end());
+    return rows;
+}
+
+// Write log table header
+void writeLogHeader(ReportWriter &out) {
+    out.appendPadded("#", 5);
+    out.appendPadded("License Plate", 18);
+    out.appendPadded("Entry Time", 18);
+    out.appendPadded("Exit Time", 18);
+    out.appendPadded("Fee (Pesos)", 15);
+    out.append("\n");
+    out.append(string(74, '-'));
+    out.append("\n");
+}
+
+// Format a bay as "37 (Level 1)", numbered from 1 for display
+string formatBay(const BayAllocator &bays, int bay) {
+    return to_string(bay + 1) + " (" + bays.zones[bays.zoneOf(bay)].name + ")";
+}
+
+// Format exit time for display
+string formatExitTime(const ParkingLog &log) {
+    return (log.status & SESSION_PARKED) ? "[Still Parked]" : formatTime(log.exitTime);
+}
+
+// Format centavos as pesos with two decimals
+string formatPesos(int64_t centavos) {
+    char buffer[32];
+    uint64_t magnitude = centavos < 0 ? 0 - (uint64_t)centavos : (uint64_t)centavos;
+    snprintf(buffer, sizeof(buffer), "%s%llu.%02d", centavos < 0 ? "-" : "", (unsigned long long)(magnitude / 100), (int)(magnitude % 100));
+    return string(buffer);
+}
+
+// Format fee for display
+string formatFee(const ParkingLog &log) {
+    if (log.status & SESSION_PARKED) return "—";
+    return formatPesos(log.fee);
+}
+
+// Write one log table row, numbered from 1
+static void writeLogRow(ReportWriter &out, long long number, const PlateText &plate, int64_t entryTime,
+                        int64_t exitTime, int64_t fee, uint8_t status) {
+    out.appendNumberPadded(number, 5);
+    out.appendPadded(plate.view(), 18);
+    out.appendTimePadded(entryTime, 18);
+    if (status & SESSION_PARKED) {
+        out.appendPadded("[Still Parked]", 18);
+        out.appendPadded("—", 15);
+    } else {
+        out.appendTimePadded(exitTime, 18);
+        out.appendFeePadded(fee, 15);
+    }
+    out.append("\n");
+}
+
+// Write every log row, walking the table one chunk of each column at a time
+void writeLogRows(ReportWriter &out, const SessionTable &logs) {
+    long long row = 0;
+    for (size_t c = 0; c < logs.statuses.chunkCount(); ++c) {
+        const PlateText *plates   = logs.plates.chunk(c);
+        const int64_t   *entries  = logs.entryTimes.chunk(c);
+        const int64_t   *exits    = logs.exitTimes.chunk(c);
+        const int64_t   *fees     = logs.fees.chunk(c);
+        const uint8_t   *statuses = logs.statuses.chunk(c);
+        size_t length = logs.statuses.chunkLength(c);
+        for (size_t i = 0; i < length; ++i) {
+            writeLogRow(out, ++row, plates[i], entries[i], exits[i], fees[i], statuses[i]);
+        }
+    }
+}
+
+// Write the log viewer's current page: only the rows in the window are
+// touched, so a page costs the same at row 10 as at row 10 million
+void writeLogPage(ReportWriter &out, const LogView &view, size_t pageRows) {
+    const SessionTable &logs = view.lot->logs;
+    out.append("+==========================================+\n");
+    out.appendCentered("EPEECT PARKING LOGS", 45);
+    out.append("+==========================================+\n");
+    writeLogHeader(out);
+    size_t end = min(view.top + pageRows, view.size());
+    for (size_t position = view.top; position < end; ++position) {
+        size_t row = view.rowAt(position);
+        writeLogRow(out, (long long)row + 1, logs.plates[row], logs.entryTimes[row], logs.exitTimes[row],
+                    logs.fees[row], logs.statuses[row]);
+    }
+    out.append(string(74, '-'));
+    out.append("\n");
+
+    if (view.size() == 0) {
+        out.append(" No sessions match.");
+    } else {
+        out.append(" Rows ");
+        out.appendNumberPadded((long long)view.rowAt(view.top) + 1, 0);
+        out.append("- ");
+        out.appendNumberPadded((long long)view.rowAt(end - 1) + 1, 0);
+        if (view.filtered) {
+            out.append("(matches ");
+            out.appendNumberPadded((long long)view.top + 1, 0);
+            out.append("- ");
+            out.appendNumberPadded((long long)end, 0);
+            out.append("of ");
+            out.appendNumber((long long)view.size());
+            out.append(")");
+        } else {
+            out.append("of ");
+            out.appendNumber((long long)logs.size());
+        }
+    }
+    if (view.filtered) {
+        out.append(" | Filter:");
+        if (!view.plateFilter.empty()) {
+            out.append(" plate contains \"");
+            out.append(view.plateFilter);
+            out.append("\"");
+        }
+        if (view.parkedOnly) out.append(" still parked");
+        if (!view.queryText.empty()) {
+            out.append(" query \"");
+            out.append(view.queryText);
+            out.append("\"");
+        }
+    }
+    out.append("\n");
+}
+
+// Recompute the rows a log view shows after its filter changed, through the
+// query engine; paging afterwards never rescans
+void filterLogView(LogView &view) {
+    const SessionTable &logs = view.lot->logs;
+    view.filtered = view.parkedOnly || !view.plateFilter.empty() || !view.queryText.empty();
+    view.matches.clear();
+    view.top = 0;
+    if (!view.filtered) return;
+
+    SessionQuery query = view.query;
+    if (view.parkedOnly) {
+        if (query.status == QUERY_CLOSED) return;
+        query.status = QUERY_OPEN;
+    }
+    if (query.restricts()) {
+        view.matches = runSessionQuery(*view.lot, query);
+        if (!view.plateFilter.empty()) {
+            erase_if(view.matches, [&](int row) { return logs.plates[row].view().find(view.plateFilter) == string_view::npos; });
+        }
+        return;
+    }
+
+    for (size_t c = 0; c < logs.plates.chunkCount(); ++c) {
+        const PlateText *plates = logs.plates.chunk(c);
+        size_t length = logs.plates.chunkLength(c), first = c * ChunkedArray<PlateText>::CHUNK_SIZE;
+        for (size_t i = 0; i < length; ++i) {
+            if (plates[i].view().find(view.plateFilter) != string_view::npos) view.matches.push_back((int)(first + i));
+        }
+    }
+}
+
+// Write the titled log table shown by viewLogs and saved by saveLogsToFile
+void writeLogReport(ReportWriter &out, const SessionTable &logs) {
+    out.append("+==========================================+\n");
+    out.appendCentered("EPEECT PARKING LOGS", 45);
+    out.append("+==========================================+\n");
+
+    if (logs.empty()) {
+        out.append("No vehicles have been logged yet.\n");
+        return;
+    }
+    writeLogHeader(out);
+    writeLogRows(out, logs);
+    out.append(string(74, '-'));
+    out.append("\n");
+}
+
+// Write the running totals: occupancy, revenue by component and stay lengths
+void writeStatsReport(ReportWriter &out, const LotStats &stats) {
+    static const char *const dwellLabels[LotStats::DWELL_BUCKETS] = {
+        "Under 1 hour", "1-2 hours", "2-3 hours", "3-6 hours", "6-12 hours", "12-24 hours", "1-2 days", "Over 2 days"
+    };
+    int64_t today = currentDayStart() / 1440;
+
+    out.append("+==========================================+\n");
+    out.appendCentered("EPEECT PARKING STATISTICS", 45);
+    out.append("+==========================================+\n");
+    out.appendPadded(" Parked Now:", 20);
+    out.appendNumberPadded(stats.openSessions(), 0);
+    out.append("\n");
+    out.appendPadded(" Sessions:", 20);
+    out.appendNumberPadded(stats.entries, 0);
+    out.append("(");
+    out.appendNumberPadded(stats.exits, 0);
+    out.append("exited)\n");
+    out.appendPadded(" Revenue Today:", 20);
+    out.appendFeePadded(stats.revenueOn(today), 12);
+    out.append("Pesos (");
+    out.appendNumberPadded(stats.exitsOn(today), 0);
+    out.append("exits)\n");
+    out.appendPadded(" Revenue Total:", 20);
+    out.appendFeePadded(stats.revenue(), 12);
+    out.append("Pesos\n");
+    out.appendPadded("   Parking Time:", 20);
+    out.appendFeePadded(stats.timeRevenue, 12);
+    out.append("\n");
+    out.appendPadded("   Overnight:", 20);
+    out.appendFeePadded(stats.overnightRevenue, 12);
+    out.append("(");
+    out.appendNumberPadded(stats.overnightExits, 0);
+    out.append("vehicles)\n");
+    out.appendPadded("   Lost Cards:", 20);
+    out.appendFeePadded(stats.lostCardRevenue, 12);
+    out.append("(");
+    out.appendNumberPadded(stats.lostCardExits, 0);
+    out.append("vehicles)\n");
+    out.appendPadded(" Average Stay:", 20);
+    if (stats.exits > 0) {
+        int64_t average = (stats.dwellMinutes + stats.exits / 2) / stats.exits;
+        out.appendNumberPadded(average / 60, 0);
+        out.append("h ");
+        out.appendNumberPadded(average % 60, 0);
+        out.append("min\n");
+    } else {
+        out.append("—\n");
+    }
+
+    out.append(" Stays by Length:\n");
+    int64_t largest = *max_element(stats.dwellHistogram, stats.dwellHistogram + LotStats::DWELL_BUCKETS);
+    for (int b = 0; b < LotStats::DWELL_BUCKETS; ++b) {
+        int64_t count = stats.dwellHistogram[b];
+        out.append("   ");
+        out.appendPadded(dwellLabels[b], 17);
+        out.appendNumberPadded(count, 10);
+        out.append(string(largest > 0 ? (count * 20 + largest - 1) / largest : 0, '#'));
+        out.append("\n");
+    }
+    out.append("--------------------------------------------\n");
+}
+
+// Write the occupancy summary: now, the last hour, today and today's busiest hour
+void writeOccupancyReport(ReportWriter &out, const OccupancyTimeline &occupancy, int64_t now) {
+    char text[96];
+    auto line = [&](const char *label, const OccupancySummary &summary) {
+        out.appendPadded(label, 20);
+        if (summary.minutes == 0) {
+            out.append("—\n");
+            return;
+        }
+        char time[TIMESTAMP_LENGTH];
+        writeTimestamp(time, summary.peakTime);
+        snprintf(text, sizeof(text), "peak %d at %.5s, avg %.1f, %lld min full\n", summary.peak, time + 11,
+                 (double)summary.occupiedMinutes / summary.minutes, (long long)summary.fullMinutes);
+        out.append(text);
+    };
+
+    int64_t today = now - now % 1440;
+    int64_t busiestHour = -1;
+    OccupancySummary busiest;
+    for (int64_t hour = today; hour <= now; hour += 60) {
+        OccupancySummary summary = occupancy.summarize(hour, min(hour + 60, now + 1));
+        if (summary.minutes > 0 && (busiestHour < 0 || summary.peak > busiest.peak)) {
+            busiestHour = hour;
+            busiest = summary;
+        }
+    }
+
+    out.append(" Occupancy:\n");
+    out.appendPadded("   Now:", 20);
+    snprintf(text, sizeof(text), "%d / %d\n", occupancy.current, occupancy.capacity);
+    out.append(text);
+    line("   Last Hour:", occupancy.summarize(now - 59, now + 1));
+    line("   Today:", occupancy.summarize(today, now + 1));
+    out.appendPadded("   Busiest Hour:", 20);
+    if (busiestHour < 0) {
+        out.append("—\n");
+    } else {
+        snprintf(text, sizeof(text), "%02d:00 (peak %d, avg %.1f)\n", (int)(busiestHour % 1440 / 60), busiest.peak,
+                 (double)busiest.occupiedMinutes / busiest.minutes);
+        out.append(text);
+    }
+    out.append("--------------------------------------------\n");
+}
+
+// Center text
+void printCentered(ostream &out, string text, int width) {
+    int pad = max(0, (width - (int)text.length()) / 2);
+    out << string(pad, ' ') << text << endl;
+}
+
+//+==========================================+
+//              REPORT WRITER
+//+==========================================+
+
+// Make room for `bytes` more characters, writing the buffer out if needed
+char *ReportWriter::reserve(size_t bytes) {
+    if (used + bytes > buffer.size()) {
+        flush();
+        if (bytes > buffer.size()) buffer.resize(bytes);
+    }
+    char *at = buffer.data() + used;
+    used += bytes;
+    return at;
+}
+
+// Append raw text
+void ReportWriter::append(string_view text) {
+    memcpy(reserve(text.size()), text.data(), text.size());
+}
+
+// Append text left-justified in `width` columns (never truncated)
+void ReportWriter::appendPadded(string_view text, int width) {
+    size_t total = max<size_t>(text.size(), width);
+    char *at = reserve(total);
+    memcpy(at, text.data(), text.size());
+    memset(at + text.size(), ' ', total - text.size());
+}
+
+// Append a whole number
+void ReportWriter::appendNumber(long long value) {
+    char *at = reserve(24);
+    used -= 24 - (to_chars(at, at + 24, value).ptr - at);
+}
+
+// Append a whole number left-justified in `width` columns, with at least one
+// space after it so long row numbers never run into the next column
+void ReportWriter::appendNumberPadded(long long value, int width) {
+    char digits[24];
+    char *end = to_chars(digits, digits + sizeof(digits), value).ptr;
+    size_t length = end - digits;
+    appendPadded(string_view(digits, length), max<int>(width, (int)length + 1));
+}
+
+// Append a time as YYYY-MM-DD HH:MM left-justified in `width` columns
+void ReportWriter::appendTimePadded(int64_t time, int width) {
+    char text[TIMESTAMP_LENGTH];
+    appendPadded(string_view(text, writeTimestamp(text, time) - text), width);
+}
+
+// Append centavos as pesos with two decimals, left-justified in `width` columns
+void ReportWriter::appendFeePadded(int64_t centavos, int width) {
+    char text[24];
+    uint64_t magnitude = centavos < 0 ? 0 - (uint64_t)centavos : (uint64_t)centavos;   // Sign goes in front, not on the cents
+    char *end = text;
+    if (centavos < 0) *end++ = '-';
+    end = to_chars(end, text + sizeof(text) - 3, magnitude / 100).ptr;
+    int cents = (int)(magnitude % 100);
+    *end++ = '.';
+    *end++ = char('0' + cents / 10);
+    *end++ = char('0' + cents % 10);
+    appendPadded(string_view(text, end - text), width);
+}
+
+// Append a centered line, matching printCentered
+void ReportWriter::appendCentered(string_view text, int width) {
+    int pad = max(0, (width - (int)text.size()) / 2);
+    memset(reserve(pad), ' ', pad);
+    append(text);
+    append("\n");
+}
+
+// Hand everything buffered to the file in one write
+bool ReportWriter::flush() {
+    if (used > 0 && fd >= 0 && ok) ok = writeAll(fd, buffer.data(), used);
+    used = 0;
+    return ok;
+}
+
+//+==========================================+
+//        GATE OPERATIONS DEFINITIONS
+//+==========================================+
+
+// Park a vehicle: assign a bay and open a session
+GateResult recordEntry(ParkingLot &lot, string_view plateText, int64_t entryTime, int &row) {
+    PlateText plate;
+    if (lot.bays.freeBays == 0) return GATE_LOT_FULL;
+    if (!normalizePlate(plateText, plate)) return GATE_BAD_PLATE;
+    if (lot.plateIndex.find(plate, lot.logs) != -1) return GATE_ALREADY_PARKED;
+
+    int bay = lot.bays.allocate();
+    if (bay < 0) return GATE_LOT_FULL;
+    row = lot.logs.append(plate, entryTime, bay);
+    lot.plateIndex.insert(plate, row);
+    lot.active.insert(row);
+    lot.indexes.byEntry.insert(entryTime, row);
+    lot.plateSearch.add(plate, row);
+    if (lot.plateSearch.size() > 2 * (lot.active.size() + PLATE_SEARCH_RECENT)) rebuildPlateSearch(lot);
+    lot.stats.entries++;
+    lot.occupancy.record(entryTime, +1, lot.bays.totalBays);
+    if (lot.journal) lot.journal->append(JOURNAL_ENTRY, plate, entryTime, 0);
+    return GATE_OK;
+}
+
+// Price a stay of `minutes` with the given tariff
+ExitCharge priceExit(const PricingTable &tariff, int64_t minutes, bool lostCard, bool overnight) {
+    ExitCharge charge;
+    charge.timeFee = calculateParkingFee(tariff, minutes, false, false);
+    charge.overnightFee = overnight ? tariff.rates.overnightFee : 0;
+    charge.lostCardFee = lostCard ? tariff.rates.lostCardFee : 0;
+    return charge;
+}
+
+// Mark a parked session exited with what it was charged and add it to the totals
+void closeSession(SessionTable &logs, LotStats &stats, int row, int64_t exitTime, uint8_t flags, const ExitCharge &charge) {
+    int64_t minutes = exitTime - logs.entryTimes[row];
+    stats.noteExit(exitTime, minutes, charge.timeFee, charge.overnightFee, charge.lostCardFee);
+
+    logs.exitTimes[row] = exitTime;
+    logs.fees[row] = charge.total();
+    logs.statuses[row] = SESSION_EXITED | (flags & (SESSION_OVERNIGHT | SESSION_LOST_CARD));
+}
+
+// Count one closed stay and what it paid
+void LotStats::noteExit(int64_t exitTime, int64_t minutes, int64_t timeFee, int64_t overnightFee, int64_t lostCardFee) {
+    exits++;
+    overnightExits += overnightFee != 0;
+    lostCardExits += lostCardFee != 0;
+    timeRevenue += timeFee;
+    overnightRevenue += overnightFee;
+    lostCardRevenue += lostCardFee;
+    dwellMinutes += minutes;
+
+    int bucket = 0;
+    while (bucket < DWELL_BUCKETS - 1 && minutes >= DWELL_LIMITS[bucket]) bucket++;
+    dwellHistogram[bucket]++;
+
+    int64_t *slot = claimDay(dayOf(exitTime));
+    if (slot) {
+        dayRevenue[slot - dayKeys] += timeFee + overnightFee + lostCardFee;
+        dayExits[slot - dayKeys]++;
+    }
+}
+
+// Ring slot for `day`, emptied first if it still holds a day RECENT_DAYS or
+// more earlier; null if `day` itself is that old. Exits can arrive out of
+// order (batch files, journal replay), so an older day never evicts a newer one.
+int64_t *LotStats::claimDay(int64_t day) {
+    int index = daySlot(day);
+    if (dayKeys[index] > day + 1) return nullptr;
+    if (dayKeys[index] != day + 1) {
+        dayKeys[index] = day + 1;
+        dayRevenue[index] = 0;
+        dayExits[index] = 0;
+    }
+    return &dayKeys[index];
+}
+
+// Revenue from exits on `day` (since 1970-01-01), 0 once it leaves the ring
+int64_t LotStats::revenueOn(int64_t day) const {
+    int index = daySlot(day);
+    return dayKeys[index] == day + 1 ? dayRevenue[index] : 0;
+}
+
+// Exits on `day` (since 1970-01-01), 0 once it leaves the ring
+int64_t LotStats::exitsOn(int64_t day) const {
+    int index = daySlot(day);
+    return dayKeys[index] == day + 1 ? dayExits[index] : 0;
+}
+
+// Check out a parked vehicle: price the stay with the current tariff, then settle it
+GateResult recordExit(ParkingLot &lot, int row, int64_t exitTime, bool lostCard, bool overnight) {
+    SessionTable &logs = lot.logs;
+    if (row < 0 || !(logs.statuses[row] & SESSION_PARKED)) return GATE_NOT_PARKED;
+    if (exitTime < logs.entryTimes[row]) return GATE_EXIT_BEFORE_ENTRY;
+
+    ExitCharge charge;
+    {
+        TariffReader reader(lot.tariff);
+        charge = priceExit(*reader.table, exitTime - logs.entryTimes[row], lostCard, overnight);
+    }
+    return settleExit(lot, row, exitTime, (overnight ? SESSION_OVERNIGHT : 0) | (lostCard ? SESSION_LOST_CARD : 0), charge);
+}
+
+// Check out a parked vehicle at a charge already worked out: close the
+// session, free the bay and journal the charge so replay repeats it exactly
+GateResult settleExit(ParkingLot &lot, int row, int64_t exitTime, uint8_t flags, const ExitCharge &charge) {
+    SessionTable &logs = lot.logs;
+    if (row < 0 || !(logs.statuses[row] & SESSION_PARKED)) return GATE_NOT_PARKED;
+    if (exitTime < logs.entryTimes[row]) return GATE_EXIT_BEFORE_ENTRY;
+
+    closeSession(logs, lot.stats, row, exitTime, flags, charge);
+    lot.plateIndex.erase(logs.plates[row], logs);
+    lot.active.erase(row);
+    lot.indexes.byExit.insert(exitTime, row);
+    lot.indexes.byFee.insert(logs.fees[row], row);
+    lot.bays.release(logs.bays[row]);
+    lot.occupancy.record(exitTime, -1, lot.bays.totalBays);
+    if (lot.journal) {
+        lot.journal->append(JOURNAL_EXIT, logs.plates[row], exitTime, logs.statuses[row] & (SESSION_OVERNIGHT | SESSION_LOST_CARD), charge);
+    }
+    return GATE_OK;
+}
+
+// Describe a gate result for operators and batch summaries
+const char *gateResultMessage(GateResult result) {
+    switch (result) {
+        case GATE_OK:             return "OK";
+        case GATE_LOT_FULL:       return "Parking Full. No available spaces.";
+        case GATE_BAD_PLATE:      return "License plate must be 1-16 characters, not counting spaces.";
+        case GATE_ALREADY_PARKED: return "Vehicle is already parked.";
+        case GATE_NOT_PARKED:     return "Vehicle is not parked.";
+        case GATE_BAD_TIME:       return "Invalid time format. Please use HH:MM or YYYY-MM-DD HH:MM (24-hour format).";
+        case GATE_EXIT_BEFORE_ENTRY: return "Exit time is earlier than the entry time.";
+        default:                  return "Unknown error.";
+    }
+}
+
+// Wait until every event applied so far is on disk (true without a journal)
+bool awaitDurable(ParkingLot &lot) {
+    if (!lot.journal) return true;
+    uint64_t sequence;
+    {
+        lock_guard<mutex> guard(lot.journal->lock);
+        sequence = lot.journal->lastSequence;
+    }
+    return lot.journal->waitDurable(sequence);
+}
+
+//+==========================================+
+//            OCCUPANCY TIMELINE
+//+==========================================+
+
+// Count one entry (+1) or exit (-1) at `time`
+void OccupancyTimeline::record(int64_t time, int delta, int totalBays) {
+    capacity = totalBays;
+    if (head == INT64_MIN) {
+        head = time;
+        start = time;
+    } else if (time > head) {
+        advance(time);
+    }
+    current += delta;
+    if (time >= windowStart()) {
+        changes[minuteSlot(time)] += delta;
+        start = min(start, time);
+    } else {
+        base += delta;      // Hours already rolled up stay as they were
+    }
+}
+
+// Move the window forward so it ends with `time`'s hour, rolling up every
+// hour that leaves it
+void OccupancyTimeline::advance(int64_t time) {
+    int64_t oldFirst = hourOf(head) - WINDOW_HOURS + 1;
+    int64_t newFirst = hourOf(time) - WINDOW_HOURS + 1;
+    int64_t from = max(oldFirst, newFirst - HISTORY_HOURS);  // Earlier hours would be overwritten anyway
+    if (from > oldFirst) {
+        // Idle for longer than the history holds: nothing in it survives
+        base = current;
+        fill(begin(changes), end(changes), 0);
+    }
+    for (int64_t hour = from; hour < newFirst; ++hour) rollUp(hour);
+    head = time;
+}
+
+// Summarize an hour leaving the window and fold its changes into base
+void OccupancyTimeline::rollUp(int64_t hour) {
+    OccupancyHour record = {};
+    int32_t level = base;
+    for (int minute = 0; minute < 60; ++minute) {
+        int32_t &change = changes[minuteSlot(hour * 60 + minute)];
+        level += change;
+        change = 0;
+        if (minute == 0 || level > record.peak) {
+            record.peak = level;
+            record.peakMinute = minute;
+        }
+        if (minute == 0 || level < record.low) record.low = level;
+        record.fullMinutes += capacity > 0 && level >= capacity;
+        record.occupiedMinutes += level;
+    }
+    hours[floorMod(hour, HISTORY_HOURS)] = record;
+    base = level;
+}
+
+// Peak, low, average and time at full over [from, to). Minutes still in the
+// window are exact; older ones come from the hourly roll-ups, prorated when
+// the range cuts an hour; minutes past the latest event hold the current
+// level. Costs O(window), no allocation.
+OccupancySummary OccupancyTimeline::summarize(int64_t from, int64_t to) const {
+    OccupancySummary summary;
+    if (head == INT64_MIN) return summary;
+    from = max({from, start, (hourOf(head) - WINDOW_HOURS + 1 - HISTORY_HOURS) * 60});
+    if (from >= to) return summary;
+
+    auto add = [&](int32_t peak, int64_t peakTime, int32_t low, int64_t fullMinutes, int64_t occupiedMinutes, int64_t minutes) {
+        if (summary.minutes == 0 || peak > summary.peak) {
+            summary.peak = peak;
+            summary.peakTime = peakTime;
+        }
+        summary.low = (summary.minutes == 0) ? low : min(summary.low, low);
+        summary.fullMinutes += fullMinutes;
+        summary.occupiedMinutes += occupiedMinutes;
+        summary.minutes += minutes;
+    };
+
+    // Hours that have left the window. Only part of a cut hour counts, and
+    // as its minutes are gone its peak is placed at the nearest one in range.
+    int64_t window = windowStart();
+    for (int64_t hour = hourOf(from); hour * 60 < min(to, window); ++hour) {
+        const OccupancyHour &record = hours[floorMod(hour, HISTORY_HOURS)];
+        int64_t begin = max(from, hour * 60), end = min(to, hour * 60 + 60);
+        int64_t minutes = end - begin;
+        add(record.peak, clamp(hour * 60 + record.peakMinute, begin, end - 1), record.low,
+            (record.fullMinutes * minutes + 30) / 60, (record.occupiedMinutes * minutes + 30) / 60, minutes);
+    }
+
+    // The window, one minute at a time; levels are a running sum from base
+    int64_t windowEnd = (hourOf(head) + 1) * 60;
+    int64_t first = max(from, window), last = min(to, windowEnd);
+    int32_t level = base;
+    int slot = minuteSlot(window);      // Consecutive minutes use consecutive slots, wrapping at the end
+    for (int64_t minute = window; minute < first; ++minute) {
+        level += changes[slot];
+        slot = (slot + 1 == WINDOW_MINUTES) ? 0 : slot + 1;
+    }
+    if (first < last) {
+        OccupancySummary span;
+        span.peak = INT32_MIN;
+        span.low = INT32_MAX;
+        for (int64_t minute = first; minute < last; ++minute) {
+            level += changes[slot];
+            slot = (slot + 1 == WINDOW_MINUTES) ? 0 : slot + 1;
+            if (level > span.peak) {
+                span.peak = level;
+                span.peakTime = minute;
+            }
+            span.low = min(span.low, level);
+            span.fullMinutes += capacity > 0 && level >= capacity;
+            span.occupiedMinutes += level;
+        }
+        add(span.peak, span.peakTime, span.low, span.fullMinutes, span.occupiedMinutes, last - first);
+    }
+
+    // Past the window nothing has happened yet
+    if (to > windowEnd) {
+        int64_t minutes = to - max(from, windowEnd);
+        add(current, max(from, windowEnd), current, (capacity > 0 && current >= capacity) ? minutes : 0, current * minutes, minutes);
+    }
+    return summary;
+}
+
+//+==========================================+
+//              TARIFF ENGINE
+//+==========================================+
+
+// Compile a rate card loaded at run time into its price table
+PricingTable::PricingTable(const TariffRates &tariffRates) : rates(tariffRates) {
+    dayFee = 24 * rates.overtimeRate;
+    vectorMaxMinutes = vectorLimit(rates);
+    loadedTable.resize(rates.standardMinutes + 1440);
+    for (int64_t m = 0; m < (int64_t)loadedTable.size(); ++m) loadedTable[m] = tariffMinuteFee(rates, m);
+    table = loadedTable.data();
+}
+
+// Price a stay: one table load, plus whole days past the table and surcharges
+int64_t PricingTable::price(int64_t minutes, bool overnight, bool lostCard) const {
+    minutes = max<int64_t>(minutes, 0);
+    int64_t extraDays = max<int64_t>(minutes - rates.standardMinutes, 0) / 1440;   // 0 inside the table
+    return table[minutes - extraDays * 1440] + extraDays * dayFee
+         + (overnight ? rates.overnightFee : 0) + (lostCard ? rates.lostCardFee : 0);
+}
+
+// Start out with the built-in rate card
+TariffPublisher::TariffPublisher() {
+    current.store(new PricingTable(StandardTariff()));
+}
+
+// Make `rates` the tariff for every exit priced from now on. Callers
+// already pricing keep their old table; it is freed once they are done.
+void TariffPublisher::publish(const TariffRates &rates) {
+    const PricingTable *replacement = new PricingTable(rates);
+    lock_guard<mutex> guard(publishLock);
+    const PricingTable *old = current.exchange(replacement);
+    swaps++;
+
+    // Two flips: a reader that read the generation just before the first
+    // flip may only register after it, under the parity the second flip drains
+    for (int flip = 0; flip < 2; ++flip) {
+        int parity = (int)(generation.fetch_add(1) & 1);
+        for (ReaderSlot &slot : slots) {
+            while (slot.readers[parity].load() != 0) this_thread::yield();
+        }
+    }
+    delete old;
+}
+
+// Pin the current table: count this thread in its slot under the current
+// generation's parity, then read the pointer
+TariffReader::TariffReader(TariffPublisher &publisher)
+    : counter([&]() -> atomic<uint32_t> & {
+          static atomic<uint32_t> nextSlot{0};
+          thread_local uint32_t slot = nextSlot.fetch_add(1) % TariffPublisher::READER_SLOTS;
+          return publisher.slots[slot].readers[publisher.generation.load() & 1];
+      }()) {
+    counter.fetch_add(1);
+    table = publisher.current.load();
+}
+
+// Read a decimal amount with up to two fractional digits as hundredths
+static bool parseHundredths(string_view text, int64_t &value) {
+    size_t dot = text.find('.');
+    string_view whole = text.substr(0, dot);
+    string_view fraction = (dot == string_view::npos) ? string_view() : text.substr(dot + 1);
+    int64_t units = 0;
+    if (whole.empty() || fraction.size() > 2) return false;
+    auto parsed = from_chars(whole.data(), whole.data() + whole.size(), units);
+    if (parsed.ec != errc() || parsed.ptr != whole.data() + whole.size() || units < 0 || units > 100000000) return false;
+    int cents = 0;
+    for (size_t i = 0; i < 2; ++i) {
+        int digit = 0;
+        if (i < fraction.size()) {
+            if (fraction[i] < '0' || fraction[i] > '9') return false;
+            digit = fraction[i] - '0';
+        }
+        cents = cents * 10 + digit;
+    }
+    value = units * 100 + cents;
+    return true;
+}
+
+// Read a rate card. One "key = value" per line, amounts in pesos, '#' starts
+// a comment; keys left out keep the built-in rate:
+//   rate_per_hour = 20.00      overtime_rate = 30.00     standard_hours = 3
+//   overnight_fee = 200.00     lost_card_fee = 200.00
+bool loadTariff(const string &path, TariffRates &rates, string &error) {
+    ifstream file(path);
+    if (!file) {
+        error = "could not open '" + path + "'";
+        return false;
+    }
+
+    rates = STANDARD_TARIFF;
+    string line;
+    int lineNumber = 0;
+    while (getline(file, line)) {
+        lineNumber++;
+        string_view text(line);
+        text = text.substr(0, text.find('#'));
+        size_t first = text.find_first_not_of(" \t\r");
+        if (first == string_view::npos) continue;
+
+        size_t equals = text.find('=');
+        string_view fields[2] = {text.substr(0, equals), equals == string_view::npos ? string_view() : text.substr(equals + 1)};
+        for (string_view &field : fields) {
+            size_t begin = field.find_first_not_of(" \t\r");
+            size_t end = field.find_last_not_of(" \t\r");
+            field = (begin == string_view::npos) ? string_view() : field.substr(begin, end - begin + 1);
+        }
+
+        int64_t amount;
+        if (equals == string_view::npos || !parseHundredths(fields[1], amount)) {
+            error = path + ":" + to_string(lineNumber) + ": expected 'key = amount'";
+            return false;
+        }
+        if      (fields[0] == "rate_per_hour") rates.ratePerHour  = amount;
+        else if (fields[0] == "overtime_rate") rates.overtimeRate = amount;
+        else if (fields[0] == "overnight_fee") rates.overnightFee = amount;
+        else if (fields[0] == "lost_card_fee") rates.lostCardFee  = amount;
+        else if (fields[0] == "standard_hours") {
+            if (amount * 60 % 100 != 0 || amount > 2400) {
+                error = path + ":" + to_string(lineNumber) + ": standard_hours must be whole minutes, at most 24 hours";
+                return false;
+            }
+            rates.standardMinutes = amount * 60 / 100;
+        } else {
+            error = path + ":" + to_string(lineNumber) + ": unknown key '" + string(fields[0]) + "'";
+            return false;
+        }
+    }
+    return true;
+}
+
+// Publish the tariff file if it changed since `stamp` (or appeared). A file
+// that fails to load leaves the current tariff in place.
+bool reloadTariff(TariffPublisher &tariff, const string &path, filesystem::file_time_type &stamp) {
+    error_code failure;
+    filesystem::file_time_type modified = filesystem::last_write_time(path, failure);
+    if (failure || modified == stamp) return false;
+    stamp = modified;
+
+    TariffRates rates;
+    string error;
+    if (!loadTariff(path, rates, error)) {
+        cerr << "Error: Tariff not changed, " << error << ".\n";
+        return false;
+    }
+    tariff.publish(rates);
+    return true;
+}
+
+//+==========================================+
+//             BATCH FEE ENGINE
+//+==========================================+
+
+// Price stays one at a time; also finishes whatever the vector kernel leaves
+static void calculateParkingFeesScalar(const PricingTable &tariff, const int64_t *minutes, const uint8_t *flags, int64_t *fees, size_t count) {
+    for (size_t i = 0; i < count; ++i) {
+        fees[i] = tariff.price(minutes[i], flags[i] & SESSION_OVERNIGHT, flags[i] & SESSION_LOST_CARD);
+    }
+}
+
+#ifdef EPEECT_FEE_AVX2
+// Four stays per step without a branch, from the rate card's formula; a group
+// with a stay outside 0..vectorMaxMinutes goes through the table instead
+__attribute__((target("avx2")))
+static void calculateParkingFeesAvx2(const PricingTable &tariff, const int64_t *minutes, const uint8_t *flags, int64_t *fees, size_t count) {
+    const TariffRates &rates      = tariff.rates;
+    const __m256i zero            = _mm256_setzero_si256();
+    const __m256i maxMinutes      = _mm256_set1_epi64x(tariff.vectorMaxMinutes);
+    const __m256i standardMinutes = _mm256_set1_epi64x(rates.standardMinutes);
+    const __m256i standardRate    = _mm256_set1_epi64x(rates.ratePerHour);
+    const __m256i overtimeRate    = _mm256_set1_epi64x(rates.overtimeRate);
+    const __m256i halfHour        = _mm256_set1_epi64x(30);
+    const __m256i reciprocal60    = _mm256_set1_epi64x(0x88888889);     // ceil(2^37 / 60)
+    const __m256i overnightFlag   = _mm256_set1_epi64x(SESSION_OVERNIGHT);
+    const __m256i lostCardFlag    = _mm256_set1_epi64x(SESSION_LOST_CARD);
+    const __m256i overnightFee    = _mm256_set1_epi64x(rates.overnightFee);
+    const __m256i lostCardFee     = _mm256_set1_epi64x(rates.lostCardFee);
+
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        __m256i stay = _mm256_loadu_si256(reinterpret_cast<const __m256i *>(minutes + i));
+        __m256i outOfRange = _mm256_or_si256(_mm256_cmpgt_epi64(stay, maxMinutes), _mm256_cmpgt_epi64(zero, stay));
+        if (!_mm256_testz_si256(outOfRange, outOfRange)) {
+            calculateParkingFeesScalar(tariff, minutes + i, flags + i, fees + i, 4);
+            continue;
+        }
+
+        __m256i standard  = _mm256_blendv_epi8(stay, standardMinutes, _mm256_cmpgt_epi64(stay, standardMinutes));
+        __m256i overtime  = _mm256_sub_epi64(stay, standard);
+        __m256i numerator = _mm256_add_epi64(_mm256_mul_epu32(standard, standardRate), _mm256_mul_epu32(overtime, overtimeRate));
+        numerator = _mm256_add_epi64(numerator, halfHour);
+        __m256i fee = _mm256_srli_epi64(_mm256_mul_epu32(numerator, reciprocal60), 37);    // Exact / 60 below 2^32
+
+        int32_t packedFlags;
+        memcpy(&packedFlags, flags + i, sizeof(packedFlags));
+        __m256i laneFlags = _mm256_cvtepu8_epi64(_mm_cvtsi32_si128(packedFlags));
+        __m256i overnight = _mm256_cmpeq_epi64(_mm256_and_si256(laneFlags, overnightFlag), overnightFlag);
+        __m256i lostCard  = _mm256_cmpeq_epi64(_mm256_and_si256(laneFlags, lostCardFlag), lostCardFlag);
+        fee = _mm256_add_epi64(fee, _mm256_and_si256(overnight, overnightFee));
+        fee = _mm256_add_epi64(fee, _mm256_and_si256(lostCard, lostCardFee));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(fees + i), fee);
+    }
+    calculateParkingFeesScalar(tariff, minutes + i, flags + i, fees + i, count - i);
+}
+#endif
+
+// Price `count` stays at once, for settlement and re-rating. Each fee is
+// calculateParkingFee(tariff, minutes[i], ...) with the overnight and
+// lost-card surcharges taken from the SESSION_* bits in flags[i]. Runs the
+// AVX2 kernel when the CPU has it.
+void calculateParkingFees(const PricingTable &tariff, const int64_t *minutes, const uint8_t *flags, int64_t *fees, size_t count) {
+    #ifdef EPEECT_FEE_AVX2
+        static const bool hasAvx2 = __builtin_cpu_supports("avx2");
+        if (hasAvx2) {
+            calculateParkingFeesAvx2(tariff, minutes, flags, fees, count);
+            return;
+        }
+    #endif
+    calculateParkingFeesScalar(tariff, minutes, flags, fees, count);
+}
+
+//+==========================================+
+//             SESSION INDEXES
+//+==========================================+
+
+// Order index entries by key alone, for binary searches on a key
+static bool keyBelow(const SortedIndex::Entry &entry, int64_t key) { return entry.key < key; }
+
+// First block that can hold `key`: entries equal to a block's first key may
+// also end the block before it
+size_t SortedIndex::firstBlock(int64_t key) const {
+    size_t block = lower_bound(lows.begin(), lows.end(), key, keyBelow) - lows.begin();
+    return block > 0 ? block - 1 : 0;
+}
+
+// About how many sessions have a key in [from, to), in O(log n): exact
+// within one or two blocks, otherwise the blocks spanned times the average
+// block size. Enough for the query planner to pick the narrowest range.
+size_t SortedIndex::estimate(int64_t from, int64_t to) const {
+    if (from >= to || blocks.empty()) return 0;
+    size_t first = firstBlock(from);
+    size_t end = lower_bound(lows.begin(), lows.end(), to, keyBelow) - lows.begin();
+    if (end <= first) return 0;
+    if (end - first > 2) return (end - first) * entries / blocks.size();
+
+    size_t total = 0;
+    for (size_t b = first; b < end; ++b) {
+        const vector<Entry> &block = blocks[b];
+        total += lower_bound(block.begin(), block.end(), to, keyBelow) - lower_bound(block.begin(), block.end(), from, keyBelow);
+    }
+    return total;
+}
+
+// Call visit(row) for every session with a key in [from, to), touching
+// only those entries
+template <typename Visit>
+void SortedIndex::forEach(int64_t from, int64_t to, Visit &&visit) const {
+    if (from >= to) return;
+    for (size_t b = firstBlock(from); b < blocks.size(); ++b) {
+        const vector<Entry> &block = blocks[b];
+        for (auto it = lower_bound(block.begin(), block.end(), from, keyBelow); it != block.end(); ++it) {
+            if (it->key >= to) return;
+            visit(it->row);
+        }
+    }
+}
+
+// Add a session to its block. Appending past the end starts a new block
+// once the last is full, so in-order keys leave full blocks; an insert
+// elsewhere splits its block in two when it doubles.
+void SortedIndex::insert(int64_t key, int row) {
+    Entry entry = {key, row};
+    entries++;
+    bool appending = blocks.empty() || !(entry < blocks.back().back());
+    if (appending && (blocks.empty() || blocks.back().size() >= BLOCK_ENTRIES)) {
+        blocks.emplace_back().reserve(BLOCK_ENTRIES);
+        blocks.back().push_back(entry);
+        lows.push_back(entry);
+        return;
+    }
+    if (appending) {
+        blocks.back().push_back(entry);
+        return;
+    }
+
+    size_t b = upper_bound(lows.begin(), lows.end(), entry) - lows.begin();
+    b = b > 0 ? b - 1 : 0;
+    vector<Entry> &block = blocks[b];
+    block.insert(upper_bound(block.begin(), block.end(), entry), entry);
+    lows[b] = block.front();
+    if (block.size() >= 2 * BLOCK_ENTRIES) {
+        vector<Entry> upper(block.begin() + BLOCK_ENTRIES, block.end());
+        block.resize(BLOCK_ENTRIES);
+        lows.insert(lows.begin() + b + 1, upper.front());
+        blocks.insert(blocks.begin() + b + 1, move(upper));
+    }
+}
+
+// Replace the whole index; entries already in order are not re-sorted
+void SortedIndex::rebuild(vector<Entry> sorted) {
+    if (!is_sorted(sorted.begin(), sorted.end())) sort(sorted.begin(), sorted.end());
+    blocks.clear();
+    lows.clear();
+    entries = sorted.size();
+    for (size_t first = 0; first < sorted.size(); first += BLOCK_ENTRIES) {
+        blocks.emplace_back(sorted.begin() + first, sorted.begin() + min(first + BLOCK_ENTRIES, sorted.size()));
+        lows.push_back(sorted[first]);
+    }
+}
+
+// Rebuild the secondary indexes from the session table, after it was
+// loaded or changed wholesale. Only the fee index when `feesOnly`.
+void rebuildIndexes(ParkingLot &lot, bool feesOnly) {
+    const SessionTable &logs = lot.logs;
+    vector<SortedIndex::Entry> entries, exits, fees;
+    for (size_t c = 0; c < logs.statuses.chunkCount(); ++c) {
+        const int64_t *entryTimes = logs.entryTimes.chunk(c);
+        const int64_t *exitTimes  = logs.exitTimes.chunk(c);
+        const int64_t *feeColumn  = logs.fees.chunk(c);
+        const uint8_t *statuses   = logs.statuses.chunk(c);
+        size_t length = logs.statuses.chunkLength(c);
+        int first = (int)(c * ChunkedArray<uint8_t>::CHUNK_SIZE);
+        for (size_t i = 0; i < length; ++i) {
+            if (!feesOnly) entries.push_back({entryTimes[i], first + (int)i});
+            if (statuses[i] & SESSION_PARKED) continue;
+            if (!feesOnly) exits.push_back({exitTimes[i], first + (int)i});
+            fees.push_back({feeColumn[i], first + (int)i});
+        }
+    }
+    if (!feesOnly) {
+        lot.indexes.byEntry.rebuild(move(entries));
+        lot.indexes.byExit.rebuild(move(exits));
+    }
+    lot.indexes.byFee.rebuild(move(fees));
+}
+
+// Whether the query narrows anything down at all
+bool SessionQuery::restricts() const {
+    return status != QUERY_ANY || entryFrom != INT64_MIN || entryTo != INT64_MAX || exitFrom != INT64_MIN
+        || exitTo != INT64_MAX || feeFrom != INT64_MIN || feeTo != INT64_MAX;
+}
+
+// Parse a query such as "closed entry>=08:00 entry<10:00 fee>200". Terms
+// are separated by spaces and must all hold:
+//   open | parked | closed | exited           session status
+//   entry|exit <op> <time>                    <op> is one of < <= = >= >
+//   fee <op> <pesos>
+// A time is HH:MM (today), YYYY-MM-DD HH:MM, or a date YYYY-MM-DD meaning
+// the whole day, so "exit=2026-10-17" is every exit that day and
+// "entry<=2026-10-17" runs through its last minute.
+bool parseSessionQuery(string_view text, int64_t today, SessionQuery &query) {
+    query = SessionQuery();
+    size_t at = 0;
+    auto skipSpaces = [&] { while (at < text.size() && text[at] == ' ') at++; };
+    for (skipSpaces(); at < text.size(); skipSpaces()) {
+        size_t start = at;
+        while (at < text.size() && isalpha((unsigned char)text[at])) at++;
+        string word(text.substr(start, at - start));
+        for (char &c : word) c = (char)tolower((unsigned char)c);
+        if (word == "open" || word == "parked") {
+            query.status = QUERY_OPEN;
+            continue;
+        }
+        if (word == "closed" || word == "exited") {
+            query.status = QUERY_CLOSED;
+            continue;
+        }
+
+        int64_t *from, *to;
+        if (word == "entry") {
+            from = &query.entryFrom;
+            to = &query.entryTo;
+        } else if (word == "exit") {
+            from = &query.exitFrom;
+            to = &query.exitTo;
+        } else if (word == "fee") {
+            from = &query.feeFrom;
+            to = &query.feeTo;
+        } else {
+            return false;
+        }
+
+        skipSpaces();
+        size_t opStart = at;
+        while (at < text.size() && (text[at] == '<' || text[at] == '>' || text[at] == '=')) at++;
+        string_view op = text.substr(opStart, at - opStart);
+        skipSpaces();
+        size_t valueStart = at;
+        while (at < text.size() && text[at] != ' ') at++;
+        string_view value = text.substr(valueStart, at - valueStart);
+
+        // Every value stands for a range [low, high): one minute, one day or one centavo
+        int64_t low, high;
+        if (word == "fee") {
+            if (!parseHundredths(value, low)) return false;
+            high = low + 1;
+        } else if (value.size() == 10 && at + 6 <= text.size() && text[at] == ' ' && text[at + 3] == ':') {
+            at += 6;        // A date followed by a clock time
+            if (!parseTimestamp(text.substr(valueStart, TIMESTAMP_LENGTH), today, low)) return false;
+            high = low + 1;
+        } else if (value.size() == 10) {
+            char midnight[TIMESTAMP_LENGTH];
+            memcpy(midnight, value.data(), 10);
+            memcpy(midnight + 10, " 00:00", 6);
+            if (!parseTimestamp(string_view(midnight, TIMESTAMP_LENGTH), today, low)) return false;
+            high = low + 1440;
+        } else {
+            if (!parseTimestamp(value, today, low)) return false;
+            high = low + 1;
+        }
+
+        if (op == "=") {
+            *from = max(*from, low);
+            *to = min(*to, high);
+        } else if (op == "<") {
+            *to = min(*to, low);
+        } else if (op == "<=") {
+            *to = min(*to, high);
+        } else if (op == ">") {
+            *from = max(*from, high);
+        } else if (op == ">=") {
+            *from = max(*from, low);
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Rows matching a query, ascending. Walks the smallest indexed range (or the
+// ActiveSet for open sessions) and checks the other terms on those rows.
+vector<int> runSessionQuery(const ParkingLot &lot, const SessionQuery &query) {
+    const SessionTable &logs = lot.logs;
+    const SessionIndexes &indexes = lot.indexes;
+    bool closedOnly = query.status == QUERY_CLOSED || query.exitFrom != INT64_MIN || query.exitTo != INT64_MAX
+                   || query.feeFrom != INT64_MIN || query.feeTo != INT64_MAX;
+    vector<int> rows;
+    if (closedOnly && query.status == QUERY_OPEN) return rows;
+
+    auto matches = [&](int row) {
+        uint8_t status = logs.statuses[row];
+        if (query.status == QUERY_OPEN && !(status & SESSION_PARKED)) return false;
+        if (closedOnly && (status & SESSION_PARKED)) return false;
+        int64_t entry = logs.entryTimes[row];
+        if (entry < query.entryFrom || entry >= query.entryTo) return false;
+        if (!closedOnly) return true;
+        int64_t exit = logs.exitTimes[row], fee = logs.fees[row];
+        return exit >= query.exitFrom && exit < query.exitTo && fee >= query.feeFrom && fee < query.feeTo;
+    };
+    auto keep = [&](int row) { if (matches(row)) rows.push_back(row); };
+
+    // Candidate drivers: 0 entry, 1 exit, 2 fee, 3 parked vehicles
+    size_t cost[4] = {
+        indexes.byEntry.estimate(query.entryFrom, query.entryTo),
+        closedOnly ? indexes.byExit.estimate(query.exitFrom, query.exitTo) : SIZE_MAX,
+        closedOnly ? indexes.byFee.estimate(query.feeFrom, query.feeTo) : SIZE_MAX,
+        query.status == QUERY_OPEN ? lot.active.size() : SIZE_MAX
+    };
+    switch (min_element(cost, cost + 4) - cost) {
+        case 0: indexes.byEntry.forEach(query.entryFrom, query.entryTo, keep); break;
+        case 1: indexes.byExit.forEach(query.exitFrom, query.exitTo, keep); break;
+        case 2: indexes.byFee.forEach(query.feeFrom, query.feeTo, keep); break;
+        case 3: for (int row : lot.active.rows) keep(row); break;
+    }
+    sort(rows.begin(), rows.end());
+    return rows;
+}
+
+//+==========================================+
+//               PLATE SEARCH
+//+==========================================+
+
+// Add a session's plate to the search index, posting its slot once under
+// each distinct bigram
+void PlateSearch::add(const PlateText &plate, int row) {
+    uint32_t slot = (uint32_t)rows.size();
+    size_t length = plate.view().size();
+    plates.push_back(plate);
+    rows.push_back(row);
+    lengths.push_back((uint8_t)length);
+    lengthCounts[length]++;
+
+    int seen[PLATE_LENGTH], seenCount = 0;
+    uint64_t signature = 0;
+    for (size_t i = 0; i + 1 < length; ++i) {
+        int gram = gramOf(plate.text[i], plate.text[i + 1]);
+        signature |= signatureBit(gram);
+        if (find(seen, seen + seenCount, gram) != seen + seenCount) continue;
+        seen[seenCount++] = gram;
+        grams[gram].push_back(slot);
+    }
+    signatures.push_back(signature);
+}
+
+// Empty the index, keeping the posting lists' memory
+void PlateSearch::clear() {
+    plates.clear();
+    rows.clear();
+    signatures.clear();
+    lengths.clear();
+    fill(begin(lengthCounts), end(lengthCounts), 0);
+    for (vector<uint32_t> &list : grams) list.clear();
+}
+
+// Refill the plate search index with every parked plate and the latest
+// PLATE_SEARCH_RECENT to leave (read off the exit-time index)
+void rebuildPlateSearch(ParkingLot &lot) {
+    PlateSearch &search = lot.plateSearch;
+    const vector<vector<SortedIndex::Entry>> &exits = lot.indexes.byExit.blocks;
+    search.clear();
+    size_t recent = 0;
+    for (size_t b = exits.size(); b-- > 0 && recent < PLATE_SEARCH_RECENT;) {
+        for (size_t i = exits[b].size(); i-- > 0 && recent < PLATE_SEARCH_RECENT; ++recent) {
+            search.add(lot.logs.plates[exits[b][i].row], exits[b][i].row);
+        }
+    }
+    for (int row : lot.active.rows) search.add(lot.logs.plates[row], row);
+}
+
+// A query character matches a plate character; '?' stands for any one
+static bool plateCharMatches(char plate, char query) { return query == '?' || plate == query; }
+
+// Whether `query` is one substitution, insertion or deletion away from
+// `plate`: what is left after their common prefix and suffix must be at
+// most one character on the longer side
+static bool withinOneEdit(string_view plate, string_view query) {
+    size_t p = plate.size(), q = query.size();
+    if (p > q + 1 || q > p + 1) return false;
+    size_t shorter = min(p, q), prefix = 0, suffix = 0;
+    while (prefix < shorter && plateCharMatches(plate[prefix], query[prefix])) prefix++;
+    while (suffix < shorter - prefix && plateCharMatches(plate[p - 1 - suffix], query[q - 1 - suffix])) suffix++;
+    return prefix + suffix + 1 >= max(p, q);
+}
+
+// How a folded plate matches a folded query, if it does at all
+static bool classifyPlate(string_view plate, string_view query, PlateMatchKind &kind) {
+    for (size_t start = 0; start + query.size() <= plate.size(); ++start) {
+        size_t i = 0;
+        while (i < query.size() && plateCharMatches(plate[start + i], query[i])) i++;
+        if (i == query.size()) {
+            kind = (start > 0) ? PLATE_CONTAINS : (query.size() == plate.size()) ? PLATE_EXACT : PLATE_PREFIX;
+            return true;
+        }
+    }
+    if (!withinOneEdit(plate, query)) return false;
+    kind = PLATE_CLOSE;
+    return true;
+}
+
+// Plates equal to, starting with, containing or one edit away from `text`
+// ('?' matches any character), best match, parked and latest first
+vector<PlateMatch> searchPlates(const ParkingLot &lot, string_view text, bool parkedOnly, size_t limit) {
+    const PlateSearch &search = lot.plateSearch;
+    const SessionTable &logs = lot.logs;
+    vector<PlateMatch> matches;
+    if (limit == 0) return matches;
+
+    // Fold the query the way plates are stored (see normalizePlate)
+    char folded[PLATE_LENGTH + 1];
+    size_t foldedLength = 0;
+    for (char c : text) {
+        if (c == ' ' || c == '\t') continue;
+        if (foldedLength == sizeof(folded)) return matches;
+        folded[foldedLength++] = (char)toupper((unsigned char)c);
+    }
+    if (foldedLength == 0) return matches;
+    string_view query(folded, foldedLength);
+
+    // The rarest readable bigram inside query[from, to), -1 if none
+    auto rarestGram = [&](size_t from, size_t to) {
+        int rarest = -1;
+        for (size_t i = from; i + 1 < to; ++i) {
+            if (query[i] == '?' || query[i + 1] == '?') continue;
+            int gram = PlateSearch::gramOf(query[i], query[i + 1]);
+            if (rarest < 0 || search.grams[gram].size() < search.grams[rarest].size()) rarest = gram;
+        }
+        return rarest;
+    };
+    auto postingCount = [&](int gram) { return gram < 0 ? search.size() : search.grams[gram].size(); };
+    auto forEachPosting = [&](int gram, auto visit) {
+        if (gram >= 0) {
+            for (uint32_t slot : search.grams[gram]) visit(slot);
+        } else {
+            for (uint32_t slot = 0; slot < search.size(); ++slot) visit(slot);
+        }
+    };
+
+    uint64_t querySignature = 0;
+    for (size_t i = 0; i + 1 < query.size(); ++i) {
+        if (query[i] != '?' && query[i + 1] != '?') querySignature |= PlateSearch::signatureBit(PlateSearch::gramOf(query[i], query[i + 1]));
+    }
+
+    struct Ranked {
+        PlateMatchKind kind;
+        bool           gone;
+        int            row;
+        uint32_t       slot;
+        bool operator<(const Ranked &other) const {
+            if (kind != other.kind) return kind < other.kind;
+            if (gone != other.gone) return !gone;
+            return row > other.row;
+        }
+    };
+    vector<Ranked> ranked;
+    auto consider = [&](uint32_t slot, bool containing, bool close) {
+        PlateMatchKind kind;
+        if (!classifyPlate(search.plates[slot].view(), query, kind) || !(kind == PLATE_CLOSE ? close : containing)) return;
+        int row = search.rows[slot];
+        bool gone = !(logs.statuses[row] & SESSION_PARKED);
+        if (!(parkedOnly && gone)) ranked.push_back({kind, gone, row, slot});
+    };
+
+    forEachPosting(rarestGram(0, query.size()), [&](uint32_t slot) {
+        if ((querySignature & ~search.signatures[slot]) == 0) consider(slot, true, false);
+    });
+
+    size_t nearCount = 0;
+    for (size_t length = query.size() - 1; length <= min(query.size() + 1, (size_t)PLATE_LENGTH); ++length) {
+        nearCount += search.lengthCounts[length];
+    }
+    if (nearCount > 0) {
+        size_t split = 1, cheapest = SIZE_MAX;
+        for (size_t h = 1; h <= query.size(); ++h) {
+            size_t cost = postingCount(rarestGram(0, h)) + postingCount(rarestGram(h, query.size()));
+            if (cost < cheapest) cheapest = cost, split = h;
+        }
+        string_view head = query.substr(0, split), tail = query.substr(split);
+        auto matchesAt = [&](uint32_t slot, size_t start, string_view part) {
+            for (size_t i = 0; i < part.size(); ++i) {
+                if (!plateCharMatches(search.plates[slot].text[start + i], part[i])) return false;
+            }
+            return true;
+        };
+        auto nearLength = [&](size_t length) { return length + 1 >= query.size() && length <= query.size() + 1; };
+        auto startsWithHead = [&](uint32_t slot) { return matchesAt(slot, 0, head); };
+        auto endsWithTail = [&](uint32_t slot) { return matchesAt(slot, search.lengths[slot] - tail.size(), tail); };
+
+        // A plate with both parts is seen from the head's side only
+        forEachPosting(rarestGram(0, split), [&](uint32_t slot) {
+            if (nearLength(search.lengths[slot]) && startsWithHead(slot)) consider(slot, false, true);
+        });
+        forEachPosting(rarestGram(split, query.size()), [&](uint32_t slot) {
+            if (nearLength(search.lengths[slot]) && endsWithTail(slot) && !startsWithHead(slot)) consider(slot, false, true);
+        });
+    }
+    sort(ranked.begin(), ranked.end());
+
+    // A plate that came back is in the index once per visit; keep its best
+    vector<string_view> kept;
+    for (size_t i = 0; i < ranked.size() && matches.size() < limit; ++i) {
+        string_view plate = search.plates[ranked[i].slot].view();
+        if (find(kept.begin(), kept.end(), plate) != kept.end()) continue;
+        kept.push_back(plate);
+        matches.push_back({ranked[i].row, ranked[i].kind});
+    }
+    return matches;
+}
+
+// Describe how a plate matched a search, for display
+const char *plateMatchLabel(PlateMatchKind kind) {
+    static const char *const labels[] = {"exact", "starts with", "contains", "close match"};
+    return labels[kind];
+}
+
+//+==========================================+
+//           WRITE-AHEAD JOURNAL
+//+==========================================+
+
+// Checksum a journal record (FNV-1a over its first `size` bytes after the checksum field)
+uint32_t journalChecksum(const JournalRecord &record) {
+    const unsigned char *bytes = reinterpret_cast<const unsigned char *>(&record);
+    uint32_t h = 2166136261u;
+    for (size_t i = sizeof(record.checksum); i < sizeof(record); ++i) {
+        h ^= bytes[i];
+        h *= 16777619u;
+    }
+    return h;
+}
+
+// Write a whole buffer, retrying short writes
+bool writeAll(int fd, const char *data, size_t size) {
+    while (size > 0) {
+    #ifdef _WIN32
+        int written = _write(fd, data, (unsigned)min<size_t>(size, 1 << 30));
+    #else
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0 && errno == EINTR) continue;
+    #endif
+        if (written <= 0) return false;
+        data += written;
+        size -= written;
+    }
+    return true;
+}
+
+// Flush a file's data to disk
+bool syncFile(int fd) {
+    #ifdef _WIN32
+        return _commit(fd) == 0;
+    #elif defined(__APPLE__)
+        return fsync(fd) == 0;
+    #else
+        return fdatasync(fd) == 0;
+    #endif
+}
+
+// Open (or create) the journal, replay it into the lot and start the flusher
+bool Journal::open(const string &path, ParkingLot &lot, long long &replayed) {
+    #ifdef _WIN32
+        fd = _open(path.c_str(), _O_RDWR | _O_CREAT | _O_BINARY, _S_IREAD | _S_IWRITE);
+    #else
+        fd = ::open(path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    #endif
+    if (fd < 0) return false;
+
+    JournalHeader header = {"EPEECTJ", JOURNAL_VERSION, sizeof(JournalRecord)};
+    JournalHeader existing;
+    long long headerBytes = read(fd, &existing, sizeof(existing));
+    if (headerBytes == 0) {
+        if (!writeAll(fd, (const char *)&header, sizeof(header)) || !syncFile(fd)) return false;
+    } else if (headerBytes != sizeof(existing) || memcmp(existing.magic, header.magic, sizeof(header.magic)) != 0
+               || existing.version != JOURNAL_VERSION || existing.recordSize != sizeof(JournalRecord)) {
+        cerr << "Error: '" << path << "' is not a compatible journal.\n";
+        return false;
+    }
+
+    // Replay records until the end or the first torn/corrupt one
+    replayed = 0;
+    long long goodBytes = sizeof(header);
+    vector<JournalRecord> buffer(4096);
+    bool intact = true;
+    while (intact) {
+        long long bytes = read(fd, buffer.data(), buffer.size() * sizeof(JournalRecord));
+        if (bytes <= 0) break;
+        size_t records = bytes / sizeof(JournalRecord);
+        if (records * sizeof(JournalRecord) != (size_t)bytes) intact = false; // Torn tail
+        for (size_t i = 0; i < records; ++i) {
+            const JournalRecord &record = buffer[i];
+            if (record.checksum != journalChecksum(record)) {
+                intact = false;
+                break;
+            }
+            if (record.sequence <= lastSequence) { // Already in the snapshot
+                goodBytes += sizeof(JournalRecord);
+                continue;
+            }
+            if (record.sequence != lastSequence + 1) { // Events missing between the snapshot and the journal
+                cerr << "Error: '" << path << "' goes on from event " << record.sequence << " but the snapshot ends at event "
+                     << lastSequence << ".\nThe snapshot is missing or older than the journal; restore it and start again. "
+                     << "The journal was left as it is.\n";
+                return false;
+            }
+            PlateText plate(record.plate);
+            if (record.type == JOURNAL_ENTRY) {
+                int row;
+                recordEntry(lot, plate.view(), record.time, row);
+            } else {
+                int row = lot.plateIndex.find(plate, lot.logs);
+                settleExit(lot, row, record.time, record.flags, {record.timeFee, record.overnightFee, record.lostCardFee});
+            }
+            lastSequence = record.sequence;
+            goodBytes += sizeof(JournalRecord);
+            replayed++;
+        }
+    }
+    durableSequence = lastSequence;
+
+    // A bad record is only a torn tail when no good record follows it
+    #ifdef _WIN32
+        bool seeked = _lseeki64(fd, goodBytes + sizeof(JournalRecord), SEEK_SET) >= 0;
+    #else
+        bool seeked = lseek(fd, goodBytes + sizeof(JournalRecord), SEEK_SET) >= 0;
+    #endif
+    for (JournalRecord record; !intact && seeked && read(fd, &record, sizeof(record)) == (long long)sizeof(record); ) {
+        if (record.checksum == journalChecksum(record)) {
+            cerr << "Error: '" << path << "' is damaged before event " << record.sequence
+                 << ". The journal was left as it is.\n";
+            return false;
+        }
+    }
+
+    // Drop a torn or corrupt tail so new records line up, then append from there
+    #ifdef _WIN32
+        if (_chsize_s(fd, goodBytes) != 0 || _lseeki64(fd, goodBytes, SEEK_SET) < 0) return false;
+    #else
+        if (ftruncate(fd, goodBytes) != 0 || lseek(fd, goodBytes, SEEK_SET) < 0) return false;
+    #endif
+
+    flusher = thread(&Journal::flushLoop, this);
+    return true;
+}
+
+// Empty the journal after a checkpoint; sequence numbers carry on
+bool Journal::reset() {
+    lock_guard<mutex> guard(lock);
+    if (!pending.empty() || durableSequence != lastSequence) return false; // Still writing
+    #ifdef _WIN32
+        return _chsize_s(fd, sizeof(JournalHeader)) == 0 && _lseeki64(fd, sizeof(JournalHeader), SEEK_SET) >= 0 && syncFile(fd);
+    #else
+        return ftruncate(fd, sizeof(JournalHeader)) == 0 && lseek(fd, sizeof(JournalHeader), SEEK_SET) >= 0 && syncFile(fd);
+    #endif
+}
+
+// Queue one event for the next group commit and return its sequence number
+uint64_t Journal::append(uint8_t type, const PlateText &plate, int64_t time, uint8_t flags, const ExitCharge &charge) {
+    JournalRecord record = {};
+    record.type = type;
+    record.flags = flags;
+    record.time = time;
+    memcpy(record.plate, plate.text, PLATE_LENGTH);
+    record.timeFee = charge.timeFee;
+    record.overnightFee = charge.overnightFee;
+    record.lostCardFee = charge.lostCardFee;
+
+    lock_guard<mutex> guard(lock);
+    record.sequence = ++lastSequence;
+    record.checksum = journalChecksum(record);
+    const char *bytes = reinterpret_cast<const char *>(&record);
+    pending.insert(pending.end(), bytes, bytes + sizeof(record));
+    flushWanted.notify_one();
+    return record.sequence;
+}
+
+// Block until `sequence` has been synced; false if the journal failed
+bool Journal::waitDurable(uint64_t sequence) {
+    unique_lock<mutex> guard(lock);
+    flushed.wait(guard, [&] { return durableSequence >= sequence || failed; });
+    return !failed;
+}
+
+// Whether a write or sync has failed, after which nothing more becomes durable
+bool Journal::hasFailed() {
+    lock_guard<mutex> guard(lock);
+    return failed;
+}
+
+// Write out whatever is pending, one write and one sync per batch. After a
+// failure nothing more is written, so the file ends at the last good commit.
+void Journal::flushLoop() {
+    vector<char> batch;
+    unique_lock<mutex> guard(lock);
+    while (true) {
+        flushWanted.wait(guard, [&] { return stopping || !pending.empty(); });
+        if (pending.empty()) break; // Stopping with nothing left to write
+        batch.swap(pending);
+        uint64_t batchEnd = lastSequence;
+        bool writable = !failed;
+        guard.unlock();
+
+        bool ok = writable && writeAll(fd, batch.data(), batch.size()) && syncFile(fd);
+        batch.clear();
+
+        guard.lock();
+        if (!ok && !failed) {
+            failed = true;
+            cerr << "Error: Could not write the journal, new events are not durable.\n";
+        }
+        if (ok) durableSequence = batchEnd;
+        commits++;
+        flushed.notify_all();
+        #ifdef __linux__
+            if (notifyFd >= 0) {
+                uint64_t one = 1;
+                if (::write(notifyFd, &one, sizeof(one)) < 0) { /* Counter saturated, the loop wakes anyway */ }
+            }
+        #endif
+    }
+}
+
+// Flush everything still pending and stop the flusher
+void Journal::close() {
+    if (fd < 0) return;
+    {
+        lock_guard<mutex> guard(lock);
+        stopping = true;
+        flushWanted.notify_one();
+    }
+    if (flusher.joinable()) flusher.join();
+    #ifdef _WIN32
+        _close(fd);
+    #else
+        ::close(fd);
+    #endif
+    fd = -1;
+}
+
+//+==========================================+
+//             SESSION SNAPSHOT
+//+==========================================+
+
+// Release a mapped or copied snapshot
+void MappedFile::release() {
+    if (!data) return;
+    #ifndef _WIN32
+        if (mapped) munmap(data, length);
+    #endif
+    if (!mapped) delete[] data;
+    data = nullptr;
+    length = 0;
+    mapped = false;
+}
+
+// Write the first `rows` records of a column as whole chunks, padding with `fill`
+template <typename T>
+bool writeSnapshotColumn(int fd, const ChunkedArray<T> &column, size_t rows, T fill, uint64_t &bytes) {
+    constexpr size_t CHUNK_SIZE = ChunkedArray<T>::CHUNK_SIZE;
+    vector<T> partial;
+    bytes = 0;
+    for (size_t first = 0; first < rows; first += CHUNK_SIZE) {
+        size_t c = first / CHUNK_SIZE;
+        const T *data;
+        if (first + CHUNK_SIZE <= column.size()) {
+            data = column.chunk(c);
+        } else {
+            partial.assign(CHUNK_SIZE, fill);
+            size_t have = (first < column.size()) ? min(column.size(), rows) - first : 0;
+            if (have > 0) copy(column.chunk(c), column.chunk(c) + have, partial.begin());
+            data = partial.data();
+        }
+        if (!writeAll(fd, reinterpret_cast<const char *>(data), CHUNK_SIZE * sizeof(T))) return false;
+        bytes += CHUNK_SIZE * sizeof(T);
+    }
+    return true;
+}
+
+// Pad the file with zeros up to the next SNAPSHOT_ALIGN boundary
+bool alignSnapshot(int fd, uint64_t &offset) {
+    static const char zeros[SNAPSHOT_ALIGN] = {};
+    size_t padding = (SNAPSHOT_ALIGN - offset % SNAPSHOT_ALIGN) % SNAPSHOT_ALIGN;
+    offset += padding;
+    return writeAll(fd, zeros, padding);
+}
+
+// Write the session table, parked set and journal position to `path`.
+// The file is written next to it and renamed into place once synced.
+bool saveSnapshot(const ParkingLot &lot, const string &path, uint64_t journalSequence) {
+    const SessionTable &logs = lot.logs;
+    string temp = path + ".tmp";
+    #ifdef _WIN32
+        int fd = _open(temp.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+    #else
+        int fd = ::open(temp.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    #endif
+    if (fd < 0) return false;
+
+    SnapshotHeader header = {};
+    memcpy(header.magic, "EPEECTS", 8);
+    header.version = SNAPSHOT_VERSION;
+    header.chunkSize = (uint32_t)ChunkedArray<uint8_t>::CHUNK_SIZE;
+    header.rowCount = logs.size();
+    header.activeCount = lot.active.size();
+    header.journalSequence = journalSequence;
+    header.totalBays = lot.bays.totalBays;
+    header.zoneCount = (uint32_t)lot.bays.zones.size();
+    header.stats = lot.stats;
+
+    // Header first (rewritten with the final offsets at the end), then columns
+    uint64_t offset = sizeof(header);
+    size_t rows = logs.size();
+    bool ok = writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(header));
+    auto column = [&](SnapshotColumn id, auto &&write) {
+        if (!ok) return;
+        ok = alignSnapshot(fd, offset);
+        header.columnOffset[id] = offset;
+        ok = ok && write(header.columnBytes[id]);
+        offset += header.columnBytes[id];
+    };
+    column(SNAPSHOT_PLATES,       [&](uint64_t &b) { return writeSnapshotColumn(fd, logs.plates, rows, PlateText(), b); });
+    column(SNAPSHOT_ENTRY_TIMES,  [&](uint64_t &b) { return writeSnapshotColumn(fd, logs.entryTimes, rows, int64_t(0), b); });
+    column(SNAPSHOT_EXIT_TIMES,   [&](uint64_t &b) { return writeSnapshotColumn(fd, logs.exitTimes, rows, int64_t(-1), b); });
+    column(SNAPSHOT_FEES,         [&](uint64_t &b) { return writeSnapshotColumn(fd, logs.fees, rows, int64_t(0), b); });
+    column(SNAPSHOT_STATUSES,     [&](uint64_t &b) { return writeSnapshotColumn(fd, logs.statuses, rows, uint8_t(0), b); });
+    column(SNAPSHOT_BAYS,         [&](uint64_t &b) { return writeSnapshotColumn(fd, logs.bays, rows, -1, b); });
+    column(SNAPSHOT_ACTIVE_SLOTS, [&](uint64_t &b) { return writeSnapshotColumn(fd, lot.active.slots, rows, -1, b); });
+    column(SNAPSHOT_ACTIVE_ROWS,  [&](uint64_t &b) {
+        b = lot.active.rows.size() * sizeof(int);
+        return writeAll(fd, reinterpret_cast<const char *>(lot.active.rows.data()), b);
+    });
+    column(SNAPSHOT_OCCUPANCY,    [&](uint64_t &b) {
+        b = sizeof(lot.occupancy);
+        return writeAll(fd, reinterpret_cast<const char *>(&lot.occupancy), b);
+    });
+
+    #ifdef _WIN32
+        ok = ok && _lseeki64(fd, 0, SEEK_SET) == 0;
+        ok = ok && writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(header)) && syncFile(fd);
+        _close(fd);
+    #else
+        ok = ok && pwrite(fd, &header, sizeof(header), 0) == (ssize_t)sizeof(header) && syncFile(fd);
+        ::close(fd);
+    #endif
+    if (!ok) {
+        filesystem::remove(temp);
+        return false;
+    }
+    error_code error;
+    filesystem::rename(temp, path, error);
+    return !error;
+}
+
+// Map a snapshot and point the session table straight at its columns. Only
+// the parked vehicles are walked (to rebuild the plate index and bays).
+bool loadSnapshot(ParkingLot &lot, const string &path, uint64_t &journalSequence) {
+    #ifdef _WIN32
+        int fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
+    #else
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    #endif
+    if (fd < 0) return false;
+
+    MappedFile &file = lot.snapshot;
+    #ifdef _WIN32
+        file.length = (size_t)_lseeki64(fd, 0, SEEK_END);
+        _lseeki64(fd, 0, SEEK_SET);
+        file.data = new char[file.length];
+        bool readOk = _read(fd, file.data, (unsigned)file.length) == (int)file.length;
+        _close(fd);
+        if (!readOk) return false;
+    #else
+        struct stat info;
+        if (fstat(fd, &info) != 0 || info.st_size < (off_t)sizeof(SnapshotHeader)) {
+            ::close(fd);
+            return false;
+        }
+        file.length = info.st_size;
+        // Private mapping: pages are shared with the page cache until a session
+        // in them changes, and changes never reach the file
+        void *data = mmap(nullptr, file.length, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+        ::close(fd);
+        if (data == MAP_FAILED) return false;
+        file.data = static_cast<char *>(data);
+        file.mapped = true;
+    #endif
+
+    SnapshotHeader header;
+    memcpy(&header, file.data, sizeof(header));
+    bool valid = file.length >= sizeof(header)
+              && memcmp(header.magic, "EPEECTS", 8) == 0
+              && header.version == SNAPSHOT_VERSION
+              && header.chunkSize == ChunkedArray<uint8_t>::CHUNK_SIZE
+              && header.totalBays == (uint32_t)lot.bays.totalBays
+              && header.zoneCount == lot.bays.zones.size();
+    for (int c = 0; valid && c < SNAPSHOT_COLUMN_COUNT; ++c) {
+        valid = header.columnOffset[c] + header.columnBytes[c] <= file.length;
+    }
+    valid = valid && header.columnBytes[SNAPSHOT_OCCUPANCY] == sizeof(OccupancyTimeline);
+    if (!valid) {
+        cerr << "Error: '" << path << "' is not a compatible snapshot.\n";
+        file.release();
+        return false;
+    }
+
+    // Every column must hold the rows the header counts, padded to whole chunks
+    // since appends fill the last one; every parked row must be a real row in a
+    // real bay whose slot points back at it, and every other slot must be -1.
+    // Anything else is a damaged file, and a bad slot would be written through.
+    static constexpr size_t columnWidth[SNAPSHOT_ACTIVE_ROWS] = {
+        sizeof(PlateText), sizeof(int64_t), sizeof(int64_t), sizeof(int64_t), sizeof(uint8_t), sizeof(int32_t), sizeof(int32_t)};
+    size_t rows = header.rowCount;
+    size_t paddedRows = (rows + header.chunkSize - 1) / header.chunkSize * header.chunkSize;
+    auto columnAt = [&](SnapshotColumn id) { return file.data + header.columnOffset[id]; };
+    bool consistent = rows <= file.length && header.activeCount <= rows
+                   && header.columnBytes[SNAPSHOT_ACTIVE_ROWS] >= header.activeCount * sizeof(int32_t);
+    for (int c = 0; consistent && c < SNAPSHOT_ACTIVE_ROWS; ++c) {
+        consistent = header.columnBytes[c] >= paddedRows * columnWidth[c];
+    }
+    const int32_t *activeRows = reinterpret_cast<const int32_t *>(columnAt(SNAPSHOT_ACTIVE_ROWS));
+    const int32_t *bays = reinterpret_cast<const int32_t *>(columnAt(SNAPSHOT_BAYS));
+    const int32_t *slots = reinterpret_cast<const int32_t *>(columnAt(SNAPSHOT_ACTIVE_SLOTS));
+    for (size_t i = 0; consistent && i < header.activeCount; ++i) {
+        consistent = activeRows[i] >= 0 && (size_t)activeRows[i] < rows
+                  && bays[activeRows[i]] >= 0 && bays[activeRows[i]] < lot.bays.totalBays
+                  && slots[activeRows[i]] == (int32_t)i;
+    }
+    for (size_t row = 0; consistent && row < rows; ++row) {
+        consistent = slots[row] == -1
+                  || (slots[row] >= 0 && (size_t)slots[row] < header.activeCount && (size_t)activeRows[slots[row]] == row);
+    }
+    if (!consistent) {
+        cerr << "Error: '" << path << "' is damaged: its columns do not match the " << rows << " sessions and "
+             << header.activeCount << " parked cars its header lists.\n";
+        file.release();
+        return false;
+    }
+
+    lot.logs.plates.adopt(reinterpret_cast<PlateText *>(columnAt(SNAPSHOT_PLATES)), rows);
+    lot.logs.entryTimes.adopt(reinterpret_cast<int64_t *>(columnAt(SNAPSHOT_ENTRY_TIMES)), rows);
+    lot.logs.exitTimes.adopt(reinterpret_cast<int64_t *>(columnAt(SNAPSHOT_EXIT_TIMES)), rows);
+    lot.logs.fees.adopt(reinterpret_cast<int64_t *>(columnAt(SNAPSHOT_FEES)), rows);
+    lot.logs.statuses.adopt(reinterpret_cast<uint8_t *>(columnAt(SNAPSHOT_STATUSES)), rows);
+    lot.logs.bays.adopt(reinterpret_cast<int32_t *>(columnAt(SNAPSHOT_BAYS)), rows);
+    lot.active.slots.adopt(reinterpret_cast<int32_t *>(columnAt(SNAPSHOT_ACTIVE_SLOTS)), rows);
+
+    lot.active.rows.assign(activeRows, activeRows + header.activeCount);
+    for (int row : lot.active.rows) {
+        lot.plateIndex.insert(lot.logs.plates[row], row);
+        lot.bays.claim(lot.logs.bays[row]);
+    }
+    lot.stats = header.stats;
+    memcpy(&lot.occupancy, columnAt(SNAPSHOT_OCCUPANCY), sizeof(OccupancyTimeline));
+    rebuildIndexes(lot);
+    rebuildPlateSearch(lot);
+    journalSequence = header.journalSequence;
+    return true;
+}
+
+// Snapshot everything applied so far and start the journal over
+bool checkpoint(ParkingLot &lot) {
+    if (!lot.journal || !awaitDurable(lot)) return false;
+    uint64_t sequence;
+    {
+        lock_guard<mutex> guard(lot.journal->lock);
+        sequence = lot.journal->lastSequence;
+    }
+    return saveSnapshot(lot, SNAPSHOT_FILE, sequence) && lot.journal->reset();
+}
+
+//+==========================================+
+//             COLUMNAR EXPORT
+//+==========================================+
+
+// Append `value` as a LEB128 varint: 7 bits per byte, low bits first
+static void putVarint(vector<char> &out, uint64_t value) {
+    while (value >= 0x80) {
+        out.push_back(char(value | 0x80));
+        value >>= 7;
+    }
+    out.push_back(char(value));
+}
+
+// Zigzag encoding, so small negative deltas stay small varints too
+static uint64_t zigzag(int64_t value) { return (uint64_t(value) << 1) ^ uint64_t(value >> 63); }
+
+// Export every session for offline analysis: ExportHeader, blocks of EXPORT_BLOCK_ROWS
+// rows, each block's file offset (uint64), then ExportFooter. Little-endian throughout.
+bool exportColumnar(const SessionTable &logs, const string &path) {
+    #ifdef _WIN32
+        int fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+    #else
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    #endif
+    if (fd < 0) return false;
+
+    ExportHeader header = {"EPEECTX", EXPORT_VERSION, (uint32_t)EXPORT_BLOCK_ROWS};
+    bool ok = writeAll(fd, reinterpret_cast<const char *>(&header), sizeof(header));
+    uint64_t offset = sizeof(header);
+
+    size_t rows = logs.size();
+    vector<uint64_t> blockOffsets;
+    vector<char> columns[EXPORT_COLUMN_COUNT], plateIds;
+    vector<uint32_t> dictionaryIds(EXPORT_BLOCK_ROWS);
+    for (size_t first = 0; ok && first < rows; first += EXPORT_BLOCK_ROWS) {
+        size_t count = min(EXPORT_BLOCK_ROWS, rows - first);
+        for (vector<char> &column : columns) column.clear();
+        plateIds.clear();
+
+        // Each block has its own plate dictionary, keyed on the first row
+        // that used the plate
+        PlateIndex dictionary;
+        uint32_t dictionarySize = 0;
+        int64_t previousEntry = 0;
+        for (size_t row = first; row < first + count; ++row) {
+            const PlateText &plate = logs.plates[row];
+            int seen = dictionary.find(plate, logs);
+            if (seen < 0) {
+                string_view text = plate.view();
+                dictionary.insert(plate, (int)row);
+                dictionaryIds[row - first] = dictionarySize++;
+                columns[EXPORT_PLATES].push_back(char(text.size()));
+                columns[EXPORT_PLATES].insert(columns[EXPORT_PLATES].end(), text.begin(), text.end());
+            } else {
+                dictionaryIds[row - first] = dictionaryIds[seen - first];
+            }
+            putVarint(plateIds, dictionaryIds[row - first]);
+
+            int64_t entry = logs.entryTimes[row];
+            uint8_t status = logs.statuses[row];
+            putVarint(columns[EXPORT_ENTRY_TIMES], zigzag(entry - previousEntry));
+            previousEntry = entry;
+            putVarint(columns[EXPORT_EXIT_TIMES], (status & SESSION_PARKED) ? 0 : uint64_t(logs.exitTimes[row] - entry) + 1);
+            putVarint(columns[EXPORT_FEES], (uint64_t)logs.fees[row]);
+            columns[EXPORT_STATUSES].push_back((char)status);
+            putVarint(columns[EXPORT_BAYS], (uint64_t)logs.bays[row]);
+        }
+        columns[EXPORT_PLATES].insert(columns[EXPORT_PLATES].end(), plateIds.begin(), plateIds.end());
+
+        ExportBlockHeader block = {(uint32_t)count, dictionarySize, {}};
+        for (int c = 0; c < EXPORT_COLUMN_COUNT; ++c) block.columnBytes[c] = (uint32_t)columns[c].size();
+        blockOffsets.push_back(offset);
+        ok = writeAll(fd, reinterpret_cast<const char *>(&block), sizeof(block));
+        offset += sizeof(block);
+        for (int c = 0; ok && c < EXPORT_COLUMN_COUNT; ++c) {
+            ok = writeAll(fd, columns[c].data(), columns[c].size());
+            offset += columns[c].size();
+        }
+    }
+
+    ExportFooter footer = {blockOffsets.size(), rows, "EPEECTX"};
+    ok = ok && writeAll(fd, reinterpret_cast<const char *>(blockOffsets.data()), blockOffsets.size() * sizeof(uint64_t));
+    ok = ok && writeAll(fd, reinterpret_cast<const char *>(&footer), sizeof(footer));
+    #ifdef _WIN32
+        _close(fd);
+    #else
+        ::close(fd);
+    #endif
+    return ok;
+}
+
+#ifdef EPEECT_BENCH
+// Reading an export back is only used by the benchmark's round-trip check
+
+// Read a varint written by putVarint; false if it runs past `end`
+static bool getVarint(const char *&at, const char *end, uint64_t &value) {
+    value = 0;
+    for (int shift = 0; at < end && shift < 64; shift += 7) {
+        uint8_t byte = (uint8_t)*at++;
+        value |= uint64_t(byte & 0x7F) << shift;
+        if (!(byte & 0x80)) return true;
+    }
+    return false;
+}
+
+// Undo zigzag
+static int64_t unzigzag(uint64_t value) { return int64_t(value >> 1) ^ -int64_t(value & 1); }
+
+// Decode one column of an export block into `block`. Exit times are stored
+// relative to entry times, so those must be decoded first.
+static bool decodeExportColumn(int column, const char *at, const char *end, const ExportBlockHeader &header, ExportBlock &block) {
+    size_t rows = header.rowCount;
+    uint64_t value;
+    switch (column) {
+        case EXPORT_PLATES:
+            block.dictionary.resize(header.dictionarySize);
+            for (PlateText &plate : block.dictionary) {
+                size_t length = (at < end) ? (uint8_t)*at++ : PLATE_LENGTH + 1;
+                if (length > PLATE_LENGTH || length > size_t(end - at)) return false;
+                plate = PlateText();
+                memcpy(plate.text, at, length);
+                at += length;
+            }
+            block.plates.resize(rows);
+            for (PlateText &plate : block.plates) {
+                if (!getVarint(at, end, value) || value >= header.dictionarySize) return false;
+                plate = block.dictionary[value];
+            }
+            return true;
+        case EXPORT_ENTRY_TIMES: {
+            block.entryTimes.resize(rows);
+            int64_t previous = 0;
+            for (int64_t &time : block.entryTimes) {
+                if (!getVarint(at, end, value)) return false;
+                time = previous += unzigzag(value);
+            }
+            return true;
+        }
+        case EXPORT_EXIT_TIMES:
+            block.exitTimes.resize(rows);
+            for (size_t i = 0; i < rows; ++i) {
+                if (!getVarint(at, end, value)) return false;
+                block.exitTimes[i] = (value == 0) ? -1 : block.entryTimes[i] + (int64_t)(value - 1);
+            }
+            return true;
+        case EXPORT_FEES:
+            block.fees.resize(rows);
+            for (int64_t &fee : block.fees) {
+                if (!getVarint(at, end, value)) return false;
+                fee = (int64_t)value;
+            }
+            return true;
+        case EXPORT_STATUSES:
+            if (size_t(end - at) < rows) return false;
+            block.statuses.assign(at, at + rows);
+            return true;
+        case EXPORT_BAYS:
+            block.bays.resize(rows);
+            for (int32_t &bay : block.bays) {
+                if (!getVarint(at, end, value)) return false;
+                bay = (int32_t)value;
+            }
+            return true;
+    }
+    return false;
+}
+
+// Read a columnar export back block by block, decoding only the columns in
+// `columns` (a mask of 1 << EXPORT_* bits) and calling visit(block) for each
+// block. Columns left out are never read from disk. False if the file is
+// not an export or is damaged.
+template <typename Visit>
+bool scanColumnarExport(const string &path, uint32_t columns, Visit &&visit) {
+    ifstream file(path, ios::binary);
+    ExportHeader header;
+    ExportFooter footer;
+    if (!file.read(reinterpret_cast<char *>(&header), sizeof(header)) || memcmp(header.magic, "EPEECTX", 8) != 0
+        || header.version != EXPORT_VERSION) return false;
+    if (!file.seekg(-(streamoff)sizeof(footer), ios::end) || !file.read(reinterpret_cast<char *>(&footer), sizeof(footer))
+        || memcmp(footer.magic, "EPEECTX", 8) != 0) return false;
+
+    vector<uint64_t> blockOffsets(footer.blockCount);
+    streamoff indexBytes = (streamoff)(footer.blockCount * sizeof(uint64_t));
+    if (!file.seekg(-(streamoff)sizeof(footer) - indexBytes, ios::end)
+        || !file.read(reinterpret_cast<char *>(blockOffsets.data()), indexBytes)) return false;
+
+    if (columns & (1u << EXPORT_EXIT_TIMES)) columns |= 1u << EXPORT_ENTRY_TIMES;
+    ExportBlock block;
+    vector<char> bytes;
+    for (uint64_t offset : blockOffsets) {
+        ExportBlockHeader blockHeader;
+        if (!file.seekg((streamoff)offset) || !file.read(reinterpret_cast<char *>(&blockHeader), sizeof(blockHeader))) return false;
+        block.rows = blockHeader.rowCount;
+        uint64_t columnOffset = offset + sizeof(blockHeader);
+        for (int c = 0; c < EXPORT_COLUMN_COUNT; ++c) {
+            if (columns & (1u << c)) {
+                bytes.resize(blockHeader.columnBytes[c]);
+                if (!file.seekg((streamoff)columnOffset) || !file.read(bytes.data(), bytes.size())
+                    || !decodeExportColumn(c, bytes.data(), bytes.data() + bytes.size(), blockHeader, block)) return false;
+            }
+            columnOffset += blockHeader.columnBytes[c];
+        }
+        visit(block);
+    }
+    return true;
+}
+#endif
+
+// Append a plate as one CSV field, quoted if it holds a comma or quote
+static void appendCsvField(ReportWriter &out, string_view text) {
+    if (text.find_first_of(",\"\r\n") == string_view::npos) {
+        out.append(text);
+        return;
+    }
+    out.append("\"");
+    for (char c : text) out.append(c == '"' ? string_view("\"\"") : string_view(&c, 1));
+    out.append("\"");
+}
+
+// Export every session as CSV for spreadsheets and BI tools, one chunk of
+// each column at a time through a ReportWriter. Columns:
+//   plate,entry_time,exit_time,minutes,fee,overnight,lost_card,bay
+// Times are YYYY-MM-DD HH:MM, the fee is in pesos, flags are 0/1 and bays
+// are numbered from 1; exit_time, minutes and fee are empty while parked,
+// and bay is empty for sessions imported from log reports.
+bool exportCsv(const SessionTable &logs, const string &path) {
+    #ifdef _WIN32
+        int fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+    #else
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    #endif
+    if (fd < 0) return false;
+
+    ReportWriter out(fd);
+    out.append("plate,entry_time,exit_time,minutes,fee,overnight,lost_card,bay\n");
+    for (size_t c = 0; c < logs.statuses.chunkCount(); ++c) {
+        const PlateText *plates   = logs.plates.chunk(c);
+        const int64_t   *entries  = logs.entryTimes.chunk(c);
+        const int64_t   *exits    = logs.exitTimes.chunk(c);
+        const int64_t   *fees     = logs.fees.chunk(c);
+        const uint8_t   *statuses = logs.statuses.chunk(c);
+        const int32_t   *bays     = logs.bays.chunk(c);
+        size_t length = logs.statuses.chunkLength(c);
+        for (size_t i = 0; i < length; ++i) {
+            appendCsvField(out, plates[i].view());
+            out.append(",");
+            out.appendTimePadded(entries[i], 0);
+            out.append(",");
+            if (!(statuses[i] & SESSION_PARKED)) {
+                out.appendTimePadded(exits[i], 0);
+                out.append(",");
+                out.appendNumber(exits[i] - entries[i]);
+                out.append(",");
+                out.appendFeePadded(fees[i], 0);
+            } else {
+                out.append(",,");
+            }
+            out.append((statuses[i] & SESSION_OVERNIGHT) ? ",1" : ",0");
+            out.append((statuses[i] & SESSION_LOST_CARD) ? ",1," : ",0,");
+            if (bays[i] >= 0) out.appendNumber(bays[i] + 1);
+            out.append("\n");
+        }
+    }
+    bool ok = out.flush();
+    #ifdef _WIN32
+        _close(fd);
+    #else
+        ::close(fd);
+    #endif
+    return ok;
+}
+
+// Price every closed session again with `tariff` and write one CSV row per
+// session, charged fee beside the new one. The session table is not changed.
+// Columns: plate,entry_time,exit_time,minutes,overnight,lost_card,charged,rerated
+RerateTotals rerateSessions(const SessionTable &logs, const PricingTable &tariff, ReportWriter &out) {
+    constexpr size_t CHUNK_SIZE = ChunkedArray<int64_t>::CHUNK_SIZE;
+    RerateTotals totals;
+    vector<int64_t> durations(CHUNK_SIZE), prices(CHUNK_SIZE);
+    out.append("plate,entry_time,exit_time,minutes,overnight,lost_card,charged,rerated\n");
+    for (size_t c = 0; c < logs.statuses.chunkCount(); ++c) {
+        const PlateText *plates   = logs.plates.chunk(c);
+        const int64_t   *entries  = logs.entryTimes.chunk(c);
+        const int64_t   *exits    = logs.exitTimes.chunk(c);
+        const int64_t   *fees     = logs.fees.chunk(c);
+        const uint8_t   *statuses = logs.statuses.chunk(c);
+        const int32_t   *bays     = logs.bays.chunk(c);
+        size_t length = logs.statuses.chunkLength(c);
+
+        for (size_t i = 0; i < length; ++i) {
+            durations[i] = (statuses[i] & SESSION_PARKED) ? 0 : exits[i] - entries[i];
+        }
+        calculateParkingFees(tariff, durations.data(), statuses, prices.data(), length);
+        for (size_t i = 0; i < length; ++i) {
+            if (statuses[i] & SESSION_PARKED) continue;
+            if (bays[i] < 0) {
+                totals.skipped++;
+                continue;
+            }
+            totals.sessions++;
+            totals.charged += fees[i];
+            totals.rerated += prices[i];
+            appendCsvField(out, plates[i].view());
+            out.append(",");
+            out.appendTimePadded(entries[i], 0);
+            out.append(",");
+            out.appendTimePadded(exits[i], 0);
+            out.append(",");
+            out.appendNumber(durations[i]);
+            out.append((statuses[i] & SESSION_OVERNIGHT) ? ",1" : ",0");
+            out.append((statuses[i] & SESSION_LOST_CARD) ? ",1," : ",0,");
+            out.appendFeePadded(fees[i], 0);
+            out.append(",");
+            out.appendFeePadded(prices[i], 0);
+            out.append("\n");
+        }
+    }
+    return totals;
+}
+
+// Write the re-rating report for the tariff now loaded (--rerate)
+int runRerate(ParkingLot &lot, const string &path) {
+    auto start = chrono::steady_clock::now();
+    #ifdef _WIN32
+        int fd = _open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+    #else
+        int fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    #endif
+    if (fd < 0) {
+        cerr << "Error: Could not write re-rating report '" << path << "'.\n";
+        return 1;
+    }
+
+    TariffReader reader(lot.tariff);
+    ReportWriter out(fd);
+    RerateTotals totals = rerateSessions(lot.logs, *reader.table, out);
+    bool ok = out.flush();
+    #ifdef _WIN32
+        _close(fd);
+    #else
+        ::close(fd);
+    #endif
+    if (!ok) {
+        cerr << "Error: Could not write re-rating report '" << path << "'.\n";
+        return 1;
+    }
+
+    double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "Re-rated " << totals.sessions << " closed sessions into '" << path << "' in " << fixed << setprecision(1)
+         << milliseconds << " ms: charged " << formatPesos(totals.charged) << ", now " << formatPesos(totals.rerated) << " Pesos.\n";
+    if (totals.skipped > 0) cout << "Left out " << totals.skipped << " imported sessions.\n";
+    return 0;
+}
+
+// Write the exports asked for on the command line (an empty path skips one)
+int runExport(const SessionTable &logs, const string &columnarPath, const string &csvPath) {
+    const string paths[2] = {columnarPath, csvPath};
+    for (int format = 0; format < 2; ++format) {
+        if (paths[format].empty()) continue;
+        auto start = chrono::steady_clock::now();
+        bool ok = (format == 0) ? exportColumnar(logs, paths[format]) : exportCsv(logs, paths[format]);
+        if (!ok) {
+            cerr << "Error: Could not write export '" << paths[format] << "'.\n";
+            return 1;
+        }
+        double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+        error_code error;
+        uintmax_t bytes = filesystem::file_size(paths[format], error);
+        cout << "Exported " << logs.size() << " sessions to '" << paths[format] << "' (" << (error ? 0 : bytes)
+             << " bytes) in " << fixed << setprecision(1) << milliseconds << " ms.\n";
+    }
+    return 0;
+}
+
+//+==========================================+
+//               LOG IMPORT
+//+==========================================+
+
+// Run work(i) for every i below `tasks` on up to one thread per core, each
+// thread taking the next unclaimed task until none are left
+template <typename Work>
+void runOnThreads(size_t tasks, Work &&work) {
+    size_t threadCount = min<size_t>(tasks, max(1u, thread::hardware_concurrency()));
+    atomic<size_t> next{0};
+    vector<thread> threads;
+    for (size_t t = 0; t < threadCount; ++t) {
+        threads.emplace_back([&] {
+            for (size_t i = next++; i < tasks; i = next++) work(i);
+        });
+    }
+    for (thread &worker : threads) worker.join();
+}
 
-    // Main program loop
-    while (choice != 4) {
-        clearScreen();
-        printMenu(TOTAL_SPACES, occupiedSpaces);
-        cin >> choice;
-        cin.ignore(numeric_limits<streamsize>::max(), '\n');
-        
-        // Validate input
-        if (cin.fail()) {
-            cin.clear();
-            cin.ignore(numeric_limits<streamsize>::max(), '\n');
-            cout << "\nInvalid input! Please enter a number (1-4).\n";
-            pauseProgram();
-            continue;
+// Saved log reports in `directory`, oldest first (the names sort by date)
+vector<string> findLogFiles(const string &directory) {
+    vector<string> paths;
+    error_code error;
+    for (const filesystem::directory_entry &entry : filesystem::directory_iterator(directory, error)) {
+        string name = entry.path().filename().string();
+        if (entry.is_regular_file(error) && name.size() > 16 && name.compare(0, 12, "ParkingLogs_") == 0
+            && name.compare(name.size() - 4, 4, ".txt") == 0) {
+            paths.push_back(entry.path().string());
         }
+    }
+    sort(paths.begin(), paths.end());
+    return paths;
+}
 
-        // Handle user choice
-        switch (choice) {
-            case 1: vehicleEntry(logs, occupiedSpaces, TOTAL_SPACES, logCount); pauseProgram(); break;  // Vehicle Entry
-            case 2: vehicleExit(logs, occupiedSpaces, TOTAL_SPACES, logCount); pauseProgram(); break;   // Vehicle Exit
-            case 3: viewLogs(logs, logCount); pauseProgram(); break;                                    // View Parking Logs
-            case 4: saveLogsToFile(logs, logCount); cout << "Exiting the program. Goodbye!\n"; return 0;// Exit Program
-            default: cout << "Invalid choice. Please try again.\n"; pauseProgram(); break;              // Invalid Choice
-        }
+// When a report was saved, from its ParkingLogs_YYYY-MM-DD_HH-MM.txt name;
+// the current minute if the name does not say
+static int64_t logFileSavedAt(const string &path) {
+    string name = filesystem::path(path).filename().string();
+    if (name.size() < 12 + TIMESTAMP_LENGTH) return currentMinute();
+    char text[TIMESTAMP_LENGTH];
+    memcpy(text, name.data() + 12, TIMESTAMP_LENGTH);
+    text[10] = ' ';
+    text[13] = ':';
+    int64_t time;
+    return parseTimestamp(string_view(text, TIMESTAMP_LENGTH), 0, time) ? time : currentMinute();
+}
+
+// Remove and return the last space-separated word of `rest`
+static string_view takeLastWord(string_view &rest) {
+    while (!rest.empty() && rest.back() == ' ') rest.remove_suffix(1);
+    size_t start = rest.find_last_of(' ');
+    start = (start == string_view::npos) ? 0 : start + 1;
+    string_view word = rest.substr(start);
+    rest = rest.substr(0, start);
+    return word;
+}
+
+// Remove a time from the end of `rest`: "YYYY-MM-DD HH:MM", or a bare
+// "HH:MM" as written by older versions
+static string_view takeLastTime(string_view &rest) {
+    string_view clock = takeLastWord(rest);
+    string_view before = rest;
+    string_view date = takeLastWord(before);
+    if (date.size() == 10 && date[4] == '-' && date[7] == '-' && clock.data() == date.data() + 11) {
+        rest = before;
+        return string_view(date.data(), TIMESTAMP_LENGTH);
     }
+    return clock;
+}
 
-    return 0;
+// Parse one row of a saved log table: "<n> <plate> <entry> <exit> <fee>".
+// Read from the right, so it takes both the current layout and the older
+// setw(15) one whose times had no date; bare times are placed at or before
+// `savedAt`. 1 for a closed session, 0 for one still parked, -1 if malformed.
+static int parseLogRow(string_view line, int64_t savedAt, ImportedSession &session) {
+    if (line.find("[Still Parked]") != string_view::npos) return 0;
+    string_view rest = line;
+    int64_t fee;
+    if (!parseHundredths(takeLastWord(rest), fee)) return -1;
+    string_view exitText = takeLastTime(rest);
+    string_view entryText = takeLastTime(rest);
+
+    long long number;
+    auto parsed = from_chars(rest.data(), rest.data() + rest.size(), number);
+    if (parsed.ec != errc()) return -1;
+    if (!normalizePlate(rest.substr(parsed.ptr - rest.data()), session.plate)) return -1;
+
+    if (!parseTimestamp(entryText, savedAt - 1439, session.entryTime)
+        || !parseTimestamp(exitText, session.entryTime, session.exitTime)
+        || session.exitTime < session.entryTime) return -1;
+    session.fee = fee;
+    return 1;
 }
-//+==========================================+
-//       HELPER FUNCTIONS DEFINITIONS
-//+==========================================+
 
-// Clear console screen
-void clearScreen() {
+// Read a whole file into `data` without going through iostreams
+static bool readWholeFile(const string &path, vector<char> &data) {
     #ifdef _WIN32
-        system("cls");
+        int fd = _open(path.c_str(), _O_RDONLY | _O_BINARY);
     #else
-        if (system("clear") != 0) {
-            cout << "\033[2J\033[1;H";
-        }
+        int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
     #endif
+    if (fd < 0) return false;
+    error_code error;
+    uintmax_t expected = filesystem::file_size(path, error);
+    data.resize(error ? 0 : (size_t)expected + 1);     // The spare byte lets the read see EOF
+    size_t used = 0;
+    for (;;) {
+        if (used == data.size()) data.resize(max<size_t>(used * 2, 1 << 16));
+        #ifdef _WIN32
+            int got = _read(fd, data.data() + used, (unsigned)(data.size() - used));
+        #else
+            ssize_t got = ::read(fd, data.data() + used, data.size() - used);
+        #endif
+        if (got <= 0) {
+            data.resize(used);
+            #ifdef _WIN32
+                _close(fd);
+            #else
+                ::close(fd);
+            #endif
+            return got == 0;
+        }
+        used += got;
+    }
 }
 
-// Pause program until Enter is pressed
-void pauseProgram() {
-    cout << "\nPress Enter to continue...";
-    cin.ignore(numeric_limits<streamsize>::max(), '\n');
+// Order sessions by entry time, then plate; equal means the same stay
+static bool importedBefore(const ImportedSession &a, const ImportedSession &b) {
+    if (a.entryTime != b.entryTime) return a.entryTime < b.entryTime;
+    return memcmp(a.plate.text, b.plate.text, PLATE_LENGTH) < 0;
 }
 
-// Validate time format HH:MM
-bool isValidTime(const string& time) {
-    int h, m;
-    if (sscanf(time.c_str(), "%d:%d", &h, &m) != 2) return false;
-    return h >= 0 && h < 24 && m >= 0 && m < 60;
-}
+// Parse the closed sessions out of one saved log report, sorted by entry
+// time and plate with duplicates removed. Only lines that start with a digit
+// are table rows; the title, header and totals never do.
+static bool parseLogFile(const string &path, vector<ImportedSession> &sessions, long long &rows, long long &malformed) {
+    vector<char> data;
+    if (!readWholeFile(path, data)) return false;
+    int64_t savedAt = logFileSavedAt(path);
+    const char *at = data.data(), *end = data.data() + data.size();
+    while (at < end) {
+        const char *newline = static_cast<const char *>(memchr(at, '\n', end - at));
+        const char *lineEnd = newline ? newline : end;
+        string_view line(at, lineEnd - at);
+        at = lineEnd + 1;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (line.empty() || line[0] < '0' || line[0] > '9') continue;
 
-// Convert "HH:MM" string to float hours
-float timeToHours(string time) {
-    int hours, minutes;
-    sscanf(time.c_str(), "%d:%d", &hours, &minutes);
-    return hours + minutes / 60.0;
+        ImportedSession session;
+        int result = parseLogRow(line, savedAt, session);
+        rows++;
+        if (result > 0) sessions.push_back(session);
+        malformed += result < 0;
+    }
+    // Rows are saved in arrival order, so this is usually sorted already
+    if (!is_sorted(sessions.begin(), sessions.end(), importedBefore)) sort(sessions.begin(), sessions.end(), importedBefore);
+    sessions.erase(unique(sessions.begin(), sessions.end(), [](const ImportedSession &a, const ImportedSession &b) {
+        return !importedBefore(a, b) && !importedBefore(b, a);
+    }), sessions.end());
+    return true;
 }
 
-// Calculate parking fee
-float calculateParkingFee(float duration, float RATE_PER_HOUR, float OVERTIME_RATE, float overnightRate, float lostCardFee) {
-    float fee = (duration <= 3) ? RATE_PER_HOUR * duration : (3 * RATE_PER_HOUR + (duration - 3) * OVERTIME_RATE);
-    fee += overnightRate + lostCardFee;
-    return fee;
+// Merge two sorted, duplicate-free session lists into one. A stay in both
+// is kept once, as `newer` has it.
+static vector<ImportedSession> mergeImported(const vector<ImportedSession> &older, const vector<ImportedSession> &newer) {
+    vector<ImportedSession> merged;
+    merged.reserve(max(older.size(), newer.size()));
+    size_t i = 0, j = 0;
+    while (i < older.size() && j < newer.size()) {
+        if (importedBefore(older[i], newer[j])) {
+            merged.push_back(older[i++]);
+        } else {
+            if (!importedBefore(newer[j], older[i])) i++;
+            merged.push_back(newer[j++]);
+        }
+    }
+    merged.insert(merged.end(), older.begin() + i, older.end());
+    merged.insert(merged.end(), newer.begin() + j, newer.end());
+    return merged;
 }
 
-// Find vehicle index by license plate
-int findVehicle(ParkingLog logs[], int logCount, string plate) {
-    for (int i = 0; i < logCount; ++i) {
-        if (logs[i].licensePlate == plate) return i;
+// Add the closed sessions from every saved log report in `directory` that the
+// table does not have yet; returns how many, -1 if a file could not be read
+long long importLogFiles(ParkingLot &lot, const string &directory, ImportCounts &counts) {
+    vector<string> paths = findLogFiles(directory);
+    size_t runs = min<size_t>(paths.size(), 4 * max(1u, thread::hardware_concurrency()));
+    vector<vector<ImportedSession>> lists(runs);
+    vector<long long> rows(paths.size()), malformed(paths.size());
+    atomic<bool> ok{true};
+    runOnThreads(runs, [&](size_t run) {
+        vector<ImportedSession> sessions;
+        for (size_t i = run * paths.size() / runs; ok && i < (run + 1) * paths.size() / runs; ++i) {
+            sessions.clear();
+            if (!parseLogFile(paths[i], sessions, rows[i], malformed[i])) ok = false;
+            lists[run] = mergeImported(lists[run], sessions);
+        }
+    });
+    if (!ok) return -1;
+
+    counts.files = paths.size();
+    counts.rows = accumulate(rows.begin(), rows.end(), 0LL);
+    counts.malformed = accumulate(malformed.begin(), malformed.end(), 0LL);
+    while (lists.size() > 1) {
+        vector<vector<ImportedSession>> merged((lists.size() + 1) / 2);
+        runOnThreads(merged.size(), [&](size_t i) {
+            merged[i] = (2 * i + 1 < lists.size()) ? mergeImported(lists[2 * i], lists[2 * i + 1]) : move(lists[2 * i]);
+        });
+        lists.swap(merged);
+    }
+    if (lists.empty()) return 0;
+
+    // What the table already holds, in the same order
+    SessionTable &logs = lot.logs;
+    vector<ImportedSession> existing(logs.size());
+    for (size_t row = 0; row < logs.size(); ++row) {
+        existing[row].plate = logs.plates[row];
+        existing[row].entryTime = logs.entryTimes[row];
+    }
+    sort(existing.begin(), existing.end(), importedBefore);
+
+    TariffReader reader(lot.tariff);
+    const PricingTable &tariff = *reader.table;
+    long long added = 0;
+    size_t known = 0;
+    for (const ImportedSession &session : lists[0]) {
+        while (known < existing.size() && importedBefore(existing[known], session)) known++;
+        if (known < existing.size() && !importedBefore(session, existing[known])) continue;
+
+        int64_t minutes = session.exitTime - session.entryTime;
+        int64_t timeFee = calculateParkingFee(tariff, minutes, false, false);
+        bool overnight = false, lostCard = false;
+        for (int flags = 0; flags < 4; ++flags) {
+            if (timeFee + ((flags & 1) ? tariff.rates.overnightFee : 0) + ((flags & 2) ? tariff.rates.lostCardFee : 0) == session.fee) {
+                overnight = flags & 1;
+                lostCard = flags & 2;
+                break;
+            }
+        }
+        int64_t overnightFee = overnight ? tariff.rates.overnightFee : 0;
+        int64_t lostCardFee = lostCard ? tariff.rates.lostCardFee : 0;
+        lot.stats.entries++;
+        lot.stats.noteExit(session.exitTime, minutes, session.fee - overnightFee - lostCardFee, overnightFee, lostCardFee);
+
+        int row = logs.append(session.plate, session.entryTime, -1);
+        logs.exitTimes[row] = session.exitTime;
+        logs.fees[row] = session.fee;
+        logs.statuses[row] = SESSION_EXITED
+                           | (overnight ? SESSION_OVERNIGHT : 0)
+                           | (lostCard ? SESSION_LOST_CARD : 0);
+        added++;
     }
-    return -1; // Not found
+    if (added > 0) {
+        rebuildIndexes(lot);
+        rebuildPlateSearch(lot);
+    }
+    return added;
 }
 
-// Print log table header
-void printLogHeader(ostream &out) {
-    out << left 
-        << setw(5)  << "#" 
-        << setw(15) << "License Plate"
-        << setw(15) << "Entry Time"
-        << setw(15) << "Exit Time"
-        << setw(15) << "Fee (Pesos)"
-        << endl;
-    out << string(60, '-') << endl;
+// Import the saved log reports in `directory` and report how it went
+int runImport(ParkingLot &lot, const string &directory) {
+    auto start = chrono::steady_clock::now();
+    ImportCounts counts;
+    long long added = importLogFiles(lot, directory, counts);
+    if (added < 0) {
+        cerr << "Error: Could not read the log files in '" << directory << "'.\n";
+        return 1;
+    }
+    double milliseconds = chrono::duration<double, milli>(chrono::steady_clock::now() - start).count();
+    cout << "Imported " << added << " sessions from " << counts.files << " log files in '" << directory << "' ("
+         << counts.rows << " rows read";
+    if (counts.malformed > 0) cout << ", " << counts.malformed << " malformed";
+    cout << ") in " << fixed << setprecision(1) << milliseconds << " ms.\n";
+    if (added > 0 && lot.journal && !checkpoint(lot)) {
+        cerr << "Error: Could not write snapshot '" << SNAPSHOT_FILE << "'.\n";
+        return 1;
+    }
+    return 0;
 }
 
-// Format exit time for display
-string formatExitTime(const ParkingLog &log) {
-    return log.exitTime.empty() ? "[Still Parked]" : log.exitTime;
+//+==========================================+
+//              BATCH MODE
+//+==========================================+
+
+// Split a comma-separated event line into trimmed fields
+int splitEventFields(string_view line, string_view fields[], int maxFields) {
+    int count = 0;
+    while (count < maxFields) {
+        size_t comma = line.find(',');
+        string_view field = line.substr(0, comma);
+        size_t first = field.find_first_not_of(" \t\r");
+        size_t last  = field.find_last_not_of(" \t\r");
+        fields[count++] = (first == string_view::npos) ? string_view() : field.substr(first, last - first + 1);
+        if (comma == string_view::npos) break;
+        line.remove_prefix(comma + 1);
+    }
+    return count;
 }
 
-// Format fee for display
-string formatFee(const ParkingLog &log) {
-    if (log.exitTime.empty()) return "—";
-    char buffer[20];
-    snprintf(buffer, sizeof(buffer), "%.2f", log.fee);
-    return string(buffer);
+// Is a Y/N answer a yes?
+bool isYes(string_view answer) {
+    return !answer.empty() && (answer[0] == 'Y' || answer[0] == 'y');
 }
 
-// Center text
-void printCentered(ostream &out, string text, int width) {
-    int pad = max(0, (width - (int)text.length()) / 2);
-    out << string(pad, ' ') << text << endl;
+// Replay gate events without prompts and report throughput. One event per line:
+//   IN,<plate>,<time>
+//   OUT,<plate>,<time>,<has card Y/N>,<overnight Y/N>
+// where <time> is "YYYY-MM-DD HH:MM", or "HH:MM" for today (entries) or the
+// first such time after the entry (exits).
+// Blank lines and lines starting with '#' are skipped.
+int runBatch(ParkingLot &lot, const string &path) {
+    ifstream file;
+    if (path != "-") {
+        file.open(path);
+        if (!file) {
+            cerr << "Error: Could not open event file '" << path << "'.\n";
+            return 1;
+        }
+    }
+    istream &in = (path == "-") ? cin : file;
+
+    long long lineNumber = 0, events = 0, entries = 0, exits = 0, malformed = 0;
+    long long rejected[GATE_RESULT_COUNT] = {};
+    string line;
+    string_view fields[5];
+    int64_t today = currentDayStart();
+
+    auto start = chrono::steady_clock::now();
+    while (getline(in, line)) {
+        lineNumber++;
+        if (line.empty() || line[0] == '#') continue;
+
+        int fieldCount = splitEventFields(line, fields, 5);
+        bool isEntry = (fields[0] == "IN"  && fieldCount == 3);
+        bool isExit  = (fields[0] == "OUT" && fieldCount == 5);
+        if (!isEntry && !isExit) {
+            if (malformed++ < 10) cerr << "Line " << lineNumber << ": malformed event skipped.\n";
+            continue;
+        }
+        events++;
+
+        GateResult result;
+        PlateText plate;
+        int row = (isExit && normalizePlate(fields[1], plate)) ? lot.plateIndex.find(plate, lot.logs) : -1;
+        int64_t time;
+        if (!parseTimestamp(fields[2], row >= 0 ? lot.logs.entryTimes[row] : today, time)) {
+            result = GATE_BAD_TIME;
+        } else if (isEntry) {
+            result = recordEntry(lot, fields[1], time, row);
+            if (result == GATE_OK) entries++;
+        } else {
+            result = recordExit(lot, row, time, !isYes(fields[3]), isYes(fields[4]));
+            if (result == GATE_OK) exits++;
+        }
+        if (result != GATE_OK) rejected[result]++;
+    }
+    bool durable = awaitDurable(lot);
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+
+    cout << "+==========================================+\n";
+    printCentered(cout, "BATCH SUMMARY", 45);
+    cout << "+==========================================+\n";
+    cout << " Events:        " << events << "\n";
+    cout << " Entries:       " << entries << "\n";
+    cout << " Exits:         " << exits << "\n";
+    for (int r = GATE_OK + 1; r < GATE_RESULT_COUNT; ++r) {
+        if (rejected[r] > 0) {
+            cout << " Rejected:      " << rejected[r] << " (" << gateResultMessage((GateResult)r) << ")\n";
+        }
+    }
+    if (malformed > 0) cout << " Malformed:     " << malformed << "\n";
+    cout << " Still Parked:  " << lot.active.size() << "\n";
+    if (lot.journal) {
+        lock_guard<mutex> guard(lot.journal->lock);
+        cout << " Journal:       " << (durable ? "" : "FAILED, ") << lot.journal->commits << " group commits\n";
+    }
+    cout << " Elapsed:       " << fixed << setprecision(3) << seconds << " s\n";
+    cout << " Throughput:    " << setprecision(0) << (seconds > 0 ? events / seconds : 0.0) << " events/s\n";
+    cout << "--------------------------------------------\n";
+
+    saveLogsToFile(lot.logs, lot.stats);
+    return 0;
 }
 
 //+==========================================+
@@ -176,73 +3949,106 @@ void printCentered(ostream &out, string text, int width) {
 //+==========================================+
 
 // Print menu
-void printMenu(int TOTAL_SPACES, int occupiedSpaces) {
+void printMenu(const BayAllocator &bays) {
     clearScreen();
     cout << "+==========================================+\n";
     printCentered(cout, "EPEECT PARKING MANAGEMENT SYSTEM", 45);
     cout << "+==========================================+\n";
-    cout << " Available Spaces: " << setw(3) << (TOTAL_SPACES - occupiedSpaces)
-         << " / " << TOTAL_SPACES << "\n";
+    cout << " Available Spaces: " << right << setw(3) << bays.freeBays
+         << " / " << bays.totalBays << "\n";
+    for (const BayZone &zone : bays.zones) {
+        cout << "   " << left << setw(15) << zone.name << right << setw(3) << zone.freeCount
+             << " / " << zone.bayCount << left << "\n";
+    }
     cout << "-----------------------------------------------\n";
     cout << " [1] Vehicle Entry\n";
     cout << " [2] Vehicle Exit\n";
     cout << " [3] View Parking Logs & Invoices\n";
-    cout << " [4] Exit Program\n";
+    cout << " [4] View Statistics\n";
+    cout << " [5] Exit Program\n";
     cout << "-----------------------------------------------\n";
     cout << " Enter your choice: ";
 }
 
 // Vehicle entry
-void vehicleEntry(ParkingLog logs[], int &occupiedSpaces, int TOTAL_SPACES, int &logCount) {
-    string plate, entryTime;
-    if (occupiedSpaces < TOTAL_SPACES) {
+void vehicleEntry(ParkingLot &lot) {
+    string plateText, entryText;
+    PlateText plate;
+    if (lot.bays.freeBays > 0) {
         cout << "\nEnter License Plate: ";
-        getline(cin, plate);
-        logs[logCount].licensePlate = plate;
+        getline(cin, plateText);
+        if (!normalizePlate(plateText, plate)) {
+            cout << "ERROR: " << gateResultMessage(GATE_BAD_PLATE) << "\n";
+            return;
+        }
+        if (findVehicle(lot.plateIndex, lot.logs, plate) != -1) {
+            cout << "ERROR: Vehicle " << plate.view() << " is already parked.\n";
+            return;
+        }
 
-        cout << "Enter Entry Time (HH:MM): ";
-        getline(cin, entryTime);
-        if (!isValidTime(entryTime)) {
-            cout << "ERROR: Invalid time format. Please use HH:MM (24-hour format).\n";
+        cout << "Enter Entry Time (HH:MM, or YYYY-MM-DD HH:MM): ";
+        getline(cin, entryText);
+        int64_t entryTime;
+        if (!parseTimestamp(entryText, currentDayStart(), entryTime)) {
+            cout << "ERROR: " << gateResultMessage(GATE_BAD_TIME) << "\n";
             return;
         }
 
-        logs[logCount].entryTime = entryTime;
-        logs[logCount].fee = 0;
-        occupiedSpaces++;
-        logCount++;
+        int row;
+        GateResult result = recordEntry(lot, plate.view(), entryTime, row);
+        if (result != GATE_OK) {
+            cout << "ERROR: " << gateResultMessage(result) << "\n";
+            return;
+        }
+        if (!awaitDurable(lot)) cout << "WARNING: Journal write failed, this entry may be lost on restart.\n";
         cout << "Vehicle entered successfully.\n";
-        cout << "Slots remaining: " << (TOTAL_SPACES - occupiedSpaces) << "\n";
+        cout << "Assigned bay: " << formatBay(lot.bays, lot.logs.bays[row]) << "\n";
+        cout << "Slots remaining: " << lot.bays.freeBays << "\n";
     } else {
         cout << "ERROR! Parking Full. No available spaces.\n";
     }
 }
 
 // Vehicle exit
-void vehicleExit(ParkingLog logs[], int &occupiedSpaces, int TOTAL_SPACES, int &logCount) {
-    string exitTime;
+void vehicleExit(ParkingLot &lot) {
+    const SessionTable &logs = lot.logs;
+    string plateText, exitText;
 
-    if (occupiedSpaces == 0) {
+    if (lot.active.empty()) {
         cout << "\nNo vehicles are currently parked.\n";
         return;
     }
 
+    // Narrow the list down from whatever of the plate could be read
+    cout << "\nEnter License Plate (part of it, ? for an unreadable character, Enter to list all): ";
+    getline(cin, plateText);
+    vector<int> availableIndices;
+    vector<PlateMatch> matches;
+    if (plateText.empty()) {
+        availableIndices = parkedRowsInArrivalOrder(lot.active);
+    } else {
+        matches = searchPlates(lot, plateText, true, PLATE_SEARCH_LIMIT);
+        if (matches.empty()) {
+            cout << "No parked vehicle matches " << plateText << ".\n";
+            return;
+        }
+        for (const PlateMatch &match : matches) availableIndices.push_back(match.row);
+    }
+    int count = (int)availableIndices.size();
+
     cout << "+==========================================+\n";
     printCentered(cout, "CURRENTLY PARKED VEHICLES", 45);
     cout << "+==========================================+\n";
-    cout << left << setw(5) << "#" << setw(15) << "License Plate" << setw(15) << "Entry Time\n";
-    cout << string(35, '-') << endl;
-
-    int availableIndices[MAX_LOGS];
-    int count = 0;
+    cout << left << setw(5) << "#" << setw(18) << "License Plate" << setw(18) << "Entry Time"
+         << (matches.empty() ? "" : "Match") << "\n";
+    cout << string(matches.empty() ? 39 : 52, '-') << endl;
 
-    for (int i = 0; i < logCount; i++) {    
-        if (logs[i].exitTime.empty()) {
-            cout << left << setw(5) << count + 1
-                 << setw(15) << logs[i].licensePlate
-                 << setw(15) << logs[i].entryTime << endl;
-            availableIndices[count++] = i;
-        }
+    for (int i = 0; i < count; i++) {
+        int row = availableIndices[i];
+        cout << left << setw(5) << i + 1
+             << setw(18) << logs.plates[row].view()
+             << setw(18) << formatTime(logs.entryTimes[row])
+             << (matches.empty() ? "" : plateMatchLabel(matches[i].kind)) << endl;
     }
 
     if (count == 0) {
@@ -263,13 +4069,13 @@ void vehicleExit(ParkingLog logs[], int &occupiedSpaces, int TOTAL_SPACES, int &
     }
 
     int index = availableIndices[exitVehicle - 1];
-    cout << "Enter Exit Time (HH:MM): ";
-    getline(cin, exitTime);
-    if (!isValidTime(exitTime)) {
-        cout << "ERROR: Invalid time format. Please use HH:MM (24-hour format).\n";
+    cout << "Enter Exit Time (HH:MM, or YYYY-MM-DD HH:MM for a stay over 24 hours): ";
+    getline(cin, exitText);
+    int64_t exitTime;
+    if (!parseTimestamp(exitText, logs.entryTimes[index], exitTime)) {
+        cout << "ERROR: " << gateResultMessage(GATE_BAD_TIME) << "\n";
         return;
     }
-    logs[index].exitTime = exitTime;
 
     char isCard, isOvernight;
     cout << "Do you have your parking card? (Y/N): ";
@@ -278,52 +4084,121 @@ void vehicleExit(ParkingLog logs[], int &occupiedSpaces, int TOTAL_SPACES, int &
     cin >> isOvernight;
     cin.ignore(numeric_limits<streamsize>::max(), '\n');
 
-    float overnightRate = (isOvernight == 'Y' || isOvernight == 'y') ? OVERNIGHT_RATE : 0.0f;
-    float lostCardFee   = (isCard == 'N' || isCard == 'n') ? LOST_CARD_FEE : 0.0f;
+    bool lostCard  = (isCard == 'N' || isCard == 'n');
+    bool overnight = (isOvernight == 'Y' || isOvernight == 'y');
+    GateResult result = recordExit(lot, index, exitTime, lostCard, overnight);
+    if (result != GATE_OK) {
+        cout << "ERROR: " << gateResultMessage(result) << "\n";
+        return;
+    }
 
-    float duration = timeToHours(logs[index].exitTime) - timeToHours(logs[index].entryTime);
-    if (duration < 0) duration += 24;
-    float fee = calculateParkingFee(duration, RATE_PER_HOUR, OVERTIME_RATE, overnightRate, lostCardFee);
-    logs[index].fee = fee;
+    if (!awaitDurable(lot)) cout << "WARNING: Journal write failed, this exit may be lost on restart.\n";
 
+    ParkingLog log = logs.row(index);
     cout << "+==========================================+\n";
     printCentered(cout, "EXIT SUMMARY", 45);
     cout << "+==========================================+\n";
-    cout << " License Plate: " << logs[index].licensePlate << endl;
-    cout << " Entry Time:    " << logs[index].entryTime << endl;
-    cout << " Exit Time:     " << logs[index].exitTime << endl;
-    cout << " Parking Fee:   " << fixed << setprecision(2) << fee << " Pesos" << endl;
+    cout << " License Plate: " << log.licensePlate.view() << endl;
+    cout << " Entry Time:    " << formatTime(log.entryTime) << endl;
+    cout << " Exit Time:     " << formatTime(log.exitTime) << endl;
+    cout << " Bay:           " << formatBay(lot.bays, log.bay) << endl;
+    cout << " Parking Fee:   " << formatFee(log) << " Pesos" << endl;
     cout << "--------------------------------------------\n";
     cout << "Vehicle exited successfully!\n";
-    occupiedSpaces--;
-    cout << "Slots remaining: " << (TOTAL_SPACES - occupiedSpaces) << "\n";
+    cout << "Slots remaining: " << lot.bays.freeBays << "\n";
 }
 
 // View parking logs
-void viewLogs(ParkingLog logs[], int logCount) {
-    cout << "+==========================================+\n";
-    printCentered(cout, "EPEECT PARKING LOGS", 45);
-    cout << "+==========================================+\n";
-
-    if (logCount == 0) {
-        cout << "No vehicles have been logged yet.\n";
+void viewLogs(const ParkingLot &lot) {
+    const SessionTable &logs = lot.logs;
+    if (logs.empty()) {
+        cout.flush(); // The report goes straight to the terminal's descriptor
+        ReportWriter out(1);
+        writeLogReport(out, logs);
+        out.flush();
+        pauseProgram();
         return;
     }
-    printLogHeader(cout);
-    for (int i = 0; i < logCount; ++i) {
-        cout << left 
-             << setw(5)  << i + 1
-             << setw(15) << logs[i].licensePlate
-             << setw(15) << logs[i].entryTime
-             << setw(15) << formatExitTime(logs[i])
-             << setw(15) << formatFee(logs[i])
-             << endl;
+
+    // One page at a time; each command is a line so it works on any console
+    LogView view;
+    view.lot = &lot;
+    string command, message;
+    for (;;) {
+        clearScreen();
+        cout.flush();
+        ReportWriter out(1, 1 << 14);
+        writeLogPage(out, view, LOG_PAGE_ROWS);
+        out.append(message);
+        out.append("\n [Enter] Next  [B] Back  [F] First  [L] Last  [number] Go to row\n"
+                   " [/text] Find plate  [P] Still parked  [?query] Filter  [C] Clear filter  [Q] Back to menu\n > ");
+        message.clear();
+        out.flush();
+        if (!getline(cin, command)) return;
+        if (!command.empty() && command.back() == '\r') command.pop_back();
+
+        size_t size = view.size(), last = size > LOG_PAGE_ROWS ? size - LOG_PAGE_ROWS : 0;
+        char key = command.empty() ? 'N' : (char)toupper((unsigned char)command[0]);
+        if (key == 'Q') {
+            return;
+        } else if (key == 'N') {
+            if (view.top + LOG_PAGE_ROWS < size) view.top += LOG_PAGE_ROWS;
+        } else if (key == 'B') {
+            view.top -= min(view.top, LOG_PAGE_ROWS);
+        } else if (key == 'F') {
+            view.top = 0;
+        } else if (key == 'L') {
+            view.top = last;
+        } else if (key == '/') {
+            // Plates are stored upper case without spaces; match them that way
+            view.plateFilter.clear();
+            for (char c : string_view(command).substr(1)) {
+                if (c != ' ' && c != '\t') view.plateFilter += (char)toupper((unsigned char)c);
+            }
+            filterLogView(view);
+        } else if (key == 'P') {
+            view.parkedOnly = !view.parkedOnly;
+            filterLogView(view);
+        } else if (key == '?') {
+            // e.g. "?closed entry>=08:00 entry<10:00 fee>200"; see parseSessionQuery
+            SessionQuery query;
+            if (!parseSessionQuery(string_view(command).substr(1), currentDayStart(), query)) {
+                message = " Could not read that query. Example: ?closed entry>=08:00 entry<10:00 fee>200\n";
+                continue;
+            }
+            view.query = query;
+            view.queryText = command.substr(1);
+            filterLogView(view);
+        } else if (key == 'C') {
+            view.plateFilter.clear();
+            view.parkedOnly = false;
+            view.query = SessionQuery();
+            view.queryText.clear();
+            filterLogView(view);
+        } else if (isdigit((unsigned char)key)) {
+            // Rows are numbered as in the full table; filtered, land on the
+            // first shown row at or after the one asked for
+            long long target = 0;
+            from_chars(command.data(), command.data() + command.size(), target);
+            size_t row = (size_t)max(0LL, target - 1);
+            size_t position = view.filtered ? lower_bound(view.matches.begin(), view.matches.end(), (int)min<size_t>(row, numeric_limits<int>::max())) - view.matches.begin()
+                                            : row;
+            view.top = min(position, size == 0 ? 0 : size - 1);
+        }
     }
-    cout << string(60, '-') << endl;
 }
 
-// Save logs to a file
-void saveLogsToFile(ParkingLog logs[], int logCount) {
+// View the running totals
+void viewStats(const ParkingLot &lot) {
+    cout.flush(); // The report goes straight to the terminal's descriptor
+    ReportWriter out(1);
+    writeStatsReport(out, lot.stats);
+    writeOccupancyReport(out, lot.occupancy, currentMinute());
+    out.flush();
+}
+
+// Save logs (and the totals under them) to a file
+void saveLogsToFile(const SessionTable &logs, const LotStats &stats) {
     using namespace std::chrono;
     auto now = system_clock::now();
     std::time_t now_time = system_clock::to_time_t(now);
@@ -333,32 +4208,827 @@ void saveLogsToFile(ParkingLog logs[], int logCount) {
     char filename[100];
     std::strftime(filename, sizeof(filename), "ParkingLogs_%Y-%m-%d_%H-%M.txt", &localTime);
 
-    ofstream file(filename, ios::out);
-    if (!file) {
+    if (!writeLogReport(logs, stats, filename)) {
         cout << "Error: Could not create log file.\n";
         return;
     }
+    cout << "\nParking logs saved successfully to '" << filename << "'.\n";
+}
 
-    file << "+==========================================+\n";
-    printCentered(file, "EPEECT PARKING LOGS", 45);
-    file << "+==========================================+\n";
+// Write the log report table, followed by the statistics, to a file
+bool writeLogReport(const SessionTable &logs, const LotStats &stats, const string &filename) {
+    #ifdef _WIN32
+        int fd = _open(filename.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+    #else
+        int fd = ::open(filename.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    #endif
+    if (fd < 0) return false;
 
-    if (logCount == 0) {
-        file << "No vehicles have been logged yet.\n";
-    } else {
-        printLogHeader(file);
-        for (int i = 0; i < logCount; ++i) {
-            file << left
-                 << setw(5)  << i + 1
-                 << setw(15) << logs[i].licensePlate
-                 << setw(15) << logs[i].entryTime
-                 << setw(15) << formatExitTime(logs[i])
-                 << setw(15) << formatFee(logs[i])
-                 << endl;
+    ReportWriter out(fd);
+    writeLogReport(out, logs);
+    out.append("\n");
+    writeStatsReport(out, stats);
+    bool ok = out.flush();
+    #ifdef _WIN32
+        _close(fd);
+    #else
+        ::close(fd);
+    #endif
+    return ok;
+}
+
+//+==========================================+
+//               GATE DAEMON
+//+==========================================+
+
+// Answer one gate request. Requests use the batch event format plus two
+// queries, one per line:
+//   IN,<plate>,<time>                            -> OK BAY <n>
+//   OUT,<plate>,<time>,<has card Y/N>,<overnight Y/N> -> OK FEE <pesos>
+//   FIND,<plate>                                 -> OK PARKED <YYYY-MM-DD HH:MM> BAY <n>
+//   STATUS                                       -> OK FREE <n> TOTAL <n>
+//   STATS                                        -> OK PARKED <n> EXITS <n> REVENUE <pesos> TODAY <pesos> AVGSTAY <minutes>
+//   OCCUPANCY[,<minutes>]                        -> OK NOW <n> PEAK <n> AT <HH:MM> LOW <n> AVG <n.n> FULL <minutes>
+//   SEARCH,<partial plate, ? for any character>  -> OK MATCHES <n>[;<plate>,<PARKED|LEFT>,<EXACT|PREFIX|CONTAINS|CLOSE>]...
+// Anything that fails answers "ERR <message>"; once the journal has failed,
+// IN and OUT answer JOURNAL_FAILED_REPLY without touching the lot.
+string handleGateRequest(ParkingLot &lot, string_view line) {
+    string_view fields[5];
+    int fieldCount = splitEventFields(line, fields, 5);
+    string_view command = fields[0];
+
+    if (command == "STATUS" && fieldCount == 1) {
+        return "OK FREE " + to_string(lot.bays.freeBays) + " TOTAL " + to_string(lot.bays.totalBays);
+    }
+    if (command == "STATS" && fieldCount == 1) {
+        const LotStats &stats = lot.stats;
+        return "OK PARKED " + to_string(stats.openSessions()) + " EXITS " + to_string(stats.exits)
+             + " REVENUE " + formatPesos(stats.revenue()) + " TODAY " + formatPesos(stats.revenueOn(currentDayStart() / 1440))
+             + " AVGSTAY " + to_string(stats.exits > 0 ? stats.dwellMinutes / stats.exits : 0);
+    }
+    if (command == "OCCUPANCY" && fieldCount <= 2) {
+        // Over the last <minutes> (default 60) up to now, for live dashboards
+        int minutes = 60;
+        if (fieldCount == 2) {
+            auto parsed = from_chars(fields[1].data(), fields[1].data() + fields[1].size(), minutes);
+            if (parsed.ec != errc() || parsed.ptr != fields[1].data() + fields[1].size() || minutes < 1) return "ERR Malformed request.";
         }
-        file << string(60, '-') << endl;
+        int64_t now = currentMinute();
+        OccupancySummary summary = lot.occupancy.summarize(now - minutes + 1, now + 1);
+        char time[TIMESTAMP_LENGTH], reply[128];
+        writeTimestamp(time, summary.peakTime);
+        snprintf(reply, sizeof(reply), "OK NOW %d PEAK %d AT %.5s LOW %d AVG %.1f FULL %lld", lot.occupancy.current, summary.peak,
+                 summary.minutes > 0 ? time + 11 : "--:--", summary.low,
+                 summary.minutes > 0 ? (double)summary.occupiedMinutes / summary.minutes : 0.0, (long long)summary.fullMinutes);
+        return reply;
+    }
+    if (command == "FIND" && fieldCount == 2) {
+        PlateText plate;
+        int row = normalizePlate(fields[1], plate) ? lot.plateIndex.find(plate, lot.logs) : -1;
+        if (row < 0) return string("ERR ") + gateResultMessage(GATE_NOT_PARKED);
+        return "OK PARKED " + formatTime(lot.logs.entryTimes[row]) + " BAY " + to_string(lot.logs.bays[row] + 1);
     }
 
-    file.close();
-    cout << "\nParking logs saved successfully to '" << filename << "'.\n";
+    if (command == "SEARCH" && fieldCount == 2) {
+        // Best candidates first, so a camera can take the first parked one
+        static const char *const kinds[] = {"EXACT", "PREFIX", "CONTAINS", "CLOSE"};
+        vector<PlateMatch> matches = searchPlates(lot, fields[1], false, PLATE_SEARCH_LIMIT);
+        string reply = "OK MATCHES " + to_string(matches.size());
+        for (const PlateMatch &match : matches) {
+            reply += ';';
+            reply += lot.logs.plates[match.row].view();
+            reply += (lot.logs.statuses[match.row] & SESSION_PARKED) ? ",PARKED," : ",LEFT,";
+            reply += kinds[match.kind];
+        }
+        return reply;
+    }
+
+    bool isEntry = (command == "IN"  && fieldCount == 3);
+    bool isExit  = (command == "OUT" && fieldCount == 5);
+    if (!isEntry && !isExit) return "ERR Malformed request.";
+    if (lot.journal && lot.journal->hasFailed()) return JOURNAL_FAILED_REPLY; // Could never be made durable
+
+    // A bare HH:MM exit is the first such time after the vehicle's entry
+    PlateText plate;
+    int row = (isExit && normalizePlate(fields[1], plate)) ? lot.plateIndex.find(plate, lot.logs) : -1;
+    int64_t time;
+    if (!parseTimestamp(fields[2], row >= 0 ? lot.logs.entryTimes[row] : currentDayStart(), time)) {
+        return string("ERR ") + gateResultMessage(GATE_BAD_TIME);
+    }
+
+    GateResult result = isEntry ? recordEntry(lot, fields[1], time, row)
+                                : recordExit(lot, row, time, !isYes(fields[3]), isYes(fields[4]));
+    if (result != GATE_OK) return string("ERR ") + gateResultMessage(result);
+    if (isEntry) return "OK BAY " + to_string(lot.logs.bays[row] + 1);
+    return "OK FEE " + formatFee(lot.logs.row(row));
+}
+
+#ifdef __linux__
+// One connected gate
+struct GateConnection {
+    uint64_t id;                // Distinguishes a reused descriptor from its previous owner
+    string   input;             // Bytes received but not yet a full line
+    string   output;            // Replies waiting for the socket to drain
+};
+
+// One request line on its way from a gate thread to the ledger
+struct GateRequest {
+    int      gate;              // Gate thread that owns the connection
+    int      fd;
+    uint64_t connectionId;
+    uint8_t  length;            // Bytes used in line, GATE_LINE_TOO_LONG if it did not fit
+    char     line[95];
+};
+constexpr uint8_t GATE_LINE_TOO_LONG = 0xFF;
+
+// A reply on its way back from the ledger, held until its event is durable
+struct PendingReply {
+    uint64_t sequence;          // Journal sequence that must be durable first
+    int      gate;
+    int      fd;
+    uint64_t connectionId;
+    string   text;
+};
+
+// Replies the ledger has released to one gate thread
+struct GateMailbox {
+    mutex lock;
+    vector<PendingReply> replies;
+    int   wakeFd = -1;          // eventfd the gate thread polls
+};
+
+// State shared by the gate threads, the ledger thread and the main thread
+struct GateDaemon {
+    ParkingLot &lot;
+    int listener     = -1;
+    int ledgerWakeFd = -1;                      // Bumped by gates when the ledger sleeps and by journal commits
+    EventRing<GateRequest> queue{GATE_QUEUE_CAPACITY};
+    vector<unique_ptr<GateMailbox>> mailboxes;  // One per gate thread
+    atomic<bool> gatesStopping{false};
+    atomic<bool> ledgerStopping{false};
+    atomic<bool> ledgerSleeping{false};
+    long long requests = 0;                     // Ledger only
+    long long batches  = 0;                     // Ledger only
+    size_t    maxDepth = 0;                     // Ledger only
+
+    explicit GateDaemon(ParkingLot &parkingLot) : lot(parkingLot) {}
+};
+
+// Send as much queued output as the socket takes; false if the peer is gone
+static bool sendPending(int fd, GateConnection &connection) {
+    while (!connection.output.empty()) {
+        ssize_t sent = send(fd, connection.output.data(), connection.output.size(), MSG_NOSIGNAL);
+        if (sent < 0) return errno == EAGAIN || errno == EWOULDBLOCK || errno == EINTR;
+        connection.output.erase(0, sent);
+    }
+    return true;
+}
+
+// Bump an eventfd counter
+static void wakeUp(int fd) {
+    uint64_t one = 1;
+    if (::write(fd, &one, sizeof(one)) < 0) { /* Counter saturated, the reader wakes anyway */ }
+}
+
+// Hand a request line to the ledger; wakes it only if it went to sleep
+static void submitRequest(GateDaemon &daemon, const GateRequest &request) {
+    daemon.queue.push(request);
+    atomic_thread_fence(memory_order_seq_cst);
+    if (daemon.ledgerSleeping.load(memory_order_relaxed)) wakeUp(daemon.ledgerWakeFd);
+}
+
+// Gate thread: accept connections, split their input into lines and queue
+// them for the ledger, and write back the replies the ledger releases. It
+// never touches the lot, so slow sockets and disk syncs never hold it up.
+static void gateLoop(GateDaemon &daemon, int gate) {
+    GateMailbox &mailbox = *daemon.mailboxes[gate];
+    int epollFd = epoll_create1(EPOLL_CLOEXEC);
+    auto watch = [&](int fd, uint32_t events, int op) {
+        epoll_event event = {};
+        event.events = events;
+        event.data.fd = fd;
+        epoll_ctl(epollFd, op, fd, &event);
+    };
+    watch(daemon.listener, EPOLLIN | EPOLLEXCLUSIVE, EPOLL_CTL_ADD);
+    watch(mailbox.wakeFd, EPOLLIN, EPOLL_CTL_ADD);
+
+    unordered_map<int, GateConnection> connections;
+    uint64_t nextConnectionId = 1;
+    vector<PendingReply> delivered;
+
+    auto closeConnection = [&](int fd) {
+        epoll_ctl(epollFd, EPOLL_CTL_DEL, fd, nullptr);
+        ::close(fd);
+        connections.erase(fd);
+    };
+
+    epoll_event events[64];
+    while (!daemon.gatesStopping.load()) {
+        int ready = epoll_wait(epollFd, events, 64, -1);
+        if (ready < 0 && errno != EINTR) break;
+
+        for (int e = 0; e < ready; ++e) {
+            int fd = events[e].data.fd;
+            if (fd == mailbox.wakeFd) {
+                uint64_t count;
+                while (read(mailbox.wakeFd, &count, sizeof(count)) > 0) {}
+                {
+                    lock_guard<mutex> guard(mailbox.lock);
+                    delivered.swap(mailbox.replies);
+                }
+                vector<int> touched;
+                for (PendingReply &reply : delivered) {
+                    auto found = connections.find(reply.fd);
+                    if (found == connections.end() || found->second.id != reply.connectionId) continue;
+                    found->second.output += reply.text;
+                    found->second.output += '\n';
+                    touched.push_back(reply.fd);
+                }
+                delivered.clear();
+                for (int client : touched) {
+                    auto found = connections.find(client);
+                    if (found == connections.end() || found->second.output.empty()) continue;
+                    if (!sendPending(client, found->second)) closeConnection(client);
+                    else if (!found->second.output.empty()) watch(client, EPOLLIN | EPOLLOUT, EPOLL_CTL_MOD);
+                }
+            } else if (fd == daemon.listener) {
+                int client;
+                while ((client = accept4(daemon.listener, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    connections[client] = GateConnection{nextConnectionId++, "", ""};
+                    watch(client, EPOLLIN, EPOLL_CTL_ADD);
+                }
+            } else {
+                auto found = connections.find(fd);
+                if (found == connections.end()) continue;
+                GateConnection &connection = found->second;
+
+                if (events[e].events & EPOLLOUT) {
+                    if (!sendPending(fd, connection)) { closeConnection(fd); continue; }
+                    if (connection.output.empty()) watch(fd, EPOLLIN, EPOLL_CTL_MOD);
+                }
+                if (!(events[e].events & (EPOLLIN | EPOLLHUP | EPOLLERR))) continue;
+
+                // Read everything available, queue every complete line
+                bool open = true;
+                char buffer[4096];
+                while (true) {
+                    ssize_t received = recv(fd, buffer, sizeof(buffer), 0);
+                    if (received > 0) { connection.input.append(buffer, received); continue; }
+                    if (received == 0 || (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)) open = false;
+                    break;
+                }
+                size_t start = 0, newline;
+                while ((newline = connection.input.find('\n', start)) != string::npos) {
+                    string_view line(connection.input.data() + start, newline - start);
+                    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+                    start = newline + 1;
+                    if (line.empty()) continue;
+
+                    GateRequest request;
+                    request.gate = gate;
+                    request.fd = fd;
+                    request.connectionId = connection.id;
+                    request.length = line.size() <= sizeof(request.line) ? (uint8_t)line.size() : GATE_LINE_TOO_LONG;
+                    if (request.length != GATE_LINE_TOO_LONG) memcpy(request.line, line.data(), line.size());
+                    submitRequest(daemon, request);
+                }
+                connection.input.erase(0, start);
+                if (connection.input.size() > 4096) open = false; // No newline in sight
+                if (!open) closeConnection(fd);
+            }
+        }
+    }
+
+    for (auto &entry : connections) ::close(entry.first);
+    ::close(epollFd);
+}
+
+// Ledger thread: the only code that touches the lot while the daemon runs.
+// It drains the queue in batches, so entries, exits and fees are applied
+// (and journaled, which numbers them) in one total order. Replies are held
+// until the journal has synced the events they acknowledge, then handed
+// back to the gate that owns the connection.
+static void ledgerLoop(GateDaemon &daemon) {
+    ParkingLot &lot = daemon.lot;
+    vector<GateRequest> batch(LEDGER_BATCH);
+    deque<PendingReply> held;
+    vector<vector<PendingReply>> outgoing(daemon.mailboxes.size());
+
+    while (true) {
+        size_t depth = daemon.queue.depth();
+        daemon.maxDepth = max(daemon.maxDepth, depth);
+        size_t count = daemon.queue.popBatch(batch.data(), batch.size());
+
+        if (count > 0) {
+            daemon.batches++;
+            bool journalFailed = lot.journal && lot.journal->hasFailed(); // Then the batch can only read
+            for (size_t i = 0; i < count; ++i) {
+                const GateRequest &request = batch[i];
+                string_view line(request.line, request.length == GATE_LINE_TOO_LONG ? 0 : request.length);
+                string reply;
+                if (request.length == GATE_LINE_TOO_LONG) {
+                    reply = "ERR Malformed request.";
+                } else if (line == "QUEUE") {
+                    reply = "OK DEPTH " + to_string(depth) + " MAX " + to_string(daemon.maxDepth)
+                          + " STALLS " + to_string(daemon.queue.stalls.load()) + " BATCHES " + to_string(daemon.batches);
+                } else {
+                    reply = handleGateRequest(lot, line);
+                }
+                held.push_back({0, request.gate, request.fd, request.connectionId, move(reply)});
+                daemon.requests++;
+            }
+            // One journal lookup covers the whole batch: every event in it is
+            // durable once the last one is
+            uint64_t sequence = 0;
+            if (lot.journal && !journalFailed) {
+                lock_guard<mutex> guard(lot.journal->lock);
+                sequence = lot.journal->lastSequence;
+            }
+            for (size_t i = held.size() - count; i < held.size(); ++i) held[i].sequence = sequence;
+        }
+
+        // Release every reply whose events are on disk. Once the journal has
+        // failed the rest never will be: they are answered with an error
+        // instead, and later batches (reads only) are not held at all.
+        uint64_t durable = UINT64_MAX;
+        bool failed = false;
+        if (lot.journal) {
+            lock_guard<mutex> guard(lot.journal->lock);
+            durable = lot.journal->durableSequence;
+            failed = lot.journal->failed;
+        }
+        if (failed) {
+            for (PendingReply &reply : held) {
+                if (reply.sequence > durable) reply.text = JOURNAL_FAILED_REPLY;
+            }
+            durable = UINT64_MAX;
+        }
+        while (!held.empty() && held.front().sequence <= durable) {
+            outgoing[held.front().gate].push_back(move(held.front()));
+            held.pop_front();
+        }
+        for (size_t gate = 0; gate < outgoing.size(); ++gate) {
+            if (outgoing[gate].empty()) continue;
+            GateMailbox &mailbox = *daemon.mailboxes[gate];
+            {
+                lock_guard<mutex> guard(mailbox.lock);
+                for (PendingReply &reply : outgoing[gate]) mailbox.replies.push_back(move(reply));
+            }
+            outgoing[gate].clear();
+            wakeUp(mailbox.wakeFd);
+        }
+
+        if (count > 0) continue;
+        if (daemon.ledgerStopping.load()) break;
+
+        // Nothing queued: sleep until a gate submits or the journal commits
+        daemon.ledgerSleeping.store(true);
+        atomic_thread_fence(memory_order_seq_cst);
+        if (daemon.queue.depth() == 0 && !daemon.ledgerStopping.load()) {
+            uint64_t wakeups;
+            if (read(daemon.ledgerWakeFd, &wakeups, sizeof(wakeups)) < 0) { /* Interrupted, just look again */ }
+        }
+        daemon.ledgerSleeping.store(false);
+    }
+}
+
+// Serve gate requests on a Unix domain socket until SIGINT/SIGTERM.
+// `gateThreads` threads handle the sockets and feed one lock-free queue; a
+// single ledger thread applies the requests in order, and the journal's
+// group commit lets a whole batch share one fsync. SIGHUP reloads
+// TARIFF_FILE without pausing the ledger.
+int runDaemon(ParkingLot &lot, const string &socketPath, int gateThreads, filesystem::file_time_type &tariffStamp) {
+    GateDaemon daemon(lot);
+    daemon.listener = socket(AF_UNIX, SOCK_STREAM | SOCK_NONBLOCK | SOCK_CLOEXEC, 0);
+    sockaddr_un address = {};
+    address.sun_family = AF_UNIX;
+    if (daemon.listener < 0 || socketPath.size() >= sizeof(address.sun_path)) {
+        cerr << "Error: Could not create gate socket.\n";
+        return 1;
+    }
+    socketPath.copy(address.sun_path, sizeof(address.sun_path) - 1);
+    unlink(socketPath.c_str());
+    if (bind(daemon.listener, (sockaddr *)&address, sizeof(address)) != 0 || listen(daemon.listener, 128) != 0) {
+        cerr << "Error: Could not listen on '" << socketPath << "'.\n";
+        ::close(daemon.listener);
+        return 1;
+    }
+
+    // Shut down cleanly on Ctrl+C / kill, reload the tariff on SIGHUP (main
+    // has already blocked all three)
+    sigset_t signals;
+    sigemptyset(&signals);
+    sigaddset(&signals, SIGINT);
+    sigaddset(&signals, SIGTERM);
+    sigaddset(&signals, SIGHUP);
+    pthread_sigmask(SIG_BLOCK, &signals, nullptr);
+    int signalFd = signalfd(-1, &signals, SFD_CLOEXEC);
+
+    daemon.ledgerWakeFd = eventfd(0, EFD_CLOEXEC);
+    if (lot.journal) {
+        lock_guard<mutex> guard(lot.journal->lock);
+        lot.journal->notifyFd = daemon.ledgerWakeFd;
+    }
+    gateThreads = max(1, gateThreads);
+    for (int gate = 0; gate < gateThreads; ++gate) {
+        daemon.mailboxes.push_back(make_unique<GateMailbox>());
+        daemon.mailboxes.back()->wakeFd = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    }
+
+    thread ledger(ledgerLoop, ref(daemon));
+    vector<thread> gates;
+    for (int gate = 0; gate < gateThreads; ++gate) gates.emplace_back(gateLoop, ref(daemon), gate);
+    cout << "Serving gates on '" << socketPath << "' with " << gateThreads << " gate threads (Ctrl+C to stop).\n" << flush;
+
+    signalfd_siginfo received;
+    while (true) {
+        if (read(signalFd, &received, sizeof(received)) < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        if (received.ssi_signo != SIGHUP) break;
+        tariffStamp = {};    // Reload even if the edit kept the timestamp
+        if (reloadTariff(lot.tariff, TARIFF_FILE, tariffStamp)) cout << "Loaded tariff from '" << TARIFF_FILE << "'.\n" << flush;
+    }
+
+    // Stop the producers first so the ledger sees everything they queued
+    daemon.gatesStopping.store(true);
+    for (auto &mailbox : daemon.mailboxes) wakeUp(mailbox->wakeFd);
+    for (thread &gate : gates) gate.join();
+    daemon.ledgerStopping.store(true);
+    wakeUp(daemon.ledgerWakeFd);
+    ledger.join();
+
+    if (lot.journal) {
+        lock_guard<mutex> guard(lot.journal->lock);
+        lot.journal->notifyFd = -1;
+    }
+    for (auto &mailbox : daemon.mailboxes) ::close(mailbox->wakeFd);
+    ::close(daemon.ledgerWakeFd);
+    ::close(signalFd);
+    ::close(daemon.listener);
+    unlink(socketPath.c_str());
+    cout << "Gate daemon stopped after " << daemon.requests << " requests (queue: max depth "
+         << daemon.maxDepth << ", " << daemon.queue.stalls.load() << " stalls, "
+         << daemon.batches << " ledger batches).\n";
+    return 0;
+}
+#else
+// The gate daemon needs epoll and Unix domain sockets
+int runDaemon(ParkingLot &, const string &, int, filesystem::file_time_type &) {
+    cerr << "Error: --daemon is only available on Linux.\n";
+    return 1;
+}
+#endif
+
+#ifdef EPEECT_BENCH
+//+==========================================+
+//     BENCHMARKS (build with -DEPEECT_BENCH)
+//+==========================================+
+//   g++ -std=c++20 -O2 -pthread -DEPEECT_BENCH "FP 7.1.cpp" -o parking_bench
+//   ./parking_bench [--max 10000000]
+
+#include <new>
+#include <random>
+
+static atomic<uint64_t> benchAllocations{0};   // Heap allocations since start
+constexpr int BENCH_NAME_WIDTH = 28;             // Name column; longer than any benchmark name
+
+// Count every allocation; GCC cannot see that these new/delete pairs match
+#if defined(__GNUC__) && !defined(__clang__)
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"
+#endif
+
+void *operator new(size_t size) {
+    benchAllocations.fetch_add(1, memory_order_relaxed);
+    if (void *p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+void *operator new[](size_t size) { return operator new(size); }
+void operator delete(void *p) noexcept { free(p); }
+void operator delete[](void *p) noexcept { free(p); }
+void operator delete(void *p, size_t) noexcept { free(p); }
+void operator delete[](void *p, size_t) noexcept { free(p); }
+
+static volatile long long benchSink;           // Keeps results observable to the optimizer
+
+// Time `ops` operations of body() and print one result row
+template <typename Body>
+void runBench(const char *name, long long records, long long ops, Body body) {
+    uint64_t allocsBefore = benchAllocations.load();
+    auto start = chrono::steady_clock::now();
+    body();
+    double seconds = chrono::duration<double>(chrono::steady_clock::now() - start).count();
+    uint64_t allocs = benchAllocations.load() - allocsBefore;
+
+    cout << left << setw(BENCH_NAME_WIDTH) << name << right
+         << setw(10) << (records > 0 ? to_string(records) : string("-"))
+         << setw(11) << ops
+         << setw(12) << fixed << setprecision(1) << seconds * 1e9 / ops
+         << setw(12) << setprecision(2) << (double)allocs / ops
+         << setw(14) << setprecision(0) << ops / seconds << "\n";
+}
+
+// Fill a lot with `records` sessions; at most `parked` stay parked, the rest have left
+void benchFill(ParkingLot &lot, long long records, int parked) {
+    lot.bays.init(1, parked);
+    char plate[32];
+    for (long long i = 0; i < records; ++i) {
+        if (lot.bays.freeBays == 0) {
+            int oldest = (int)(i - parked);
+            recordExit(lot, oldest, i + 90, i % 7 == 0, i % 11 == 0);
+        }
+        snprintf(plate, sizeof(plate), "BN%09lld", i);
+        int row;
+        recordEntry(lot, plate, i, row);
+    }
+}
+
+// Run every benchmark at 10^3 .. max records
+int runBenchmarks(int argc, char *argv[]) {
+    long long maxRecords = 10000000;
+    for (int i = 1; i + 1 < argc; ++i) {
+        if (string(argv[i]) == "--max") maxRecords = atoll(argv[i + 1]);
+    }
+
+    cout << left << setw(BENCH_NAME_WIDTH) << "benchmark" << right << setw(10) << "records" << setw(11) << "ops"
+         << setw(12) << "ns/op" << setw(12) << "allocs/op" << setw(14) << "ops/s" << "\n";
+    cout << string(BENCH_NAME_WIDTH + 59, '-') << "\n";
+
+    // Size-independent helpers
+    {
+        mt19937 rng(42);
+        vector<int64_t> durations(1 << 16);
+        for (int64_t &d : durations) d = rng() % 2880;
+        const long long ops = 10000000;
+        const PricingTable standard{StandardTariff()};
+        runBench("calculateParkingFee", 0, ops, [&] {
+            int64_t total = 0;
+            for (long long i = 0; i < ops; ++i) total += calculateParkingFee(standard, durations[i & 0xFFFF], i & 8, i & 16);
+            benchSink = total;
+        });
+        TariffPublisher tariff;
+        runBench("TariffReader+price", 0, ops, [&] {
+            int64_t total = 0;
+            for (long long i = 0; i < ops; ++i) {
+                TariffReader reader(tariff);
+                total += reader.table->price(durations[i & 0xFFFF], i & 8, i & 16);
+            }
+            benchSink = total;
+        });
+
+        vector<uint8_t> flags(durations.size());
+        for (size_t i = 0; i < flags.size(); ++i) flags[i] = SESSION_EXITED | (i & 8 ? SESSION_OVERNIGHT : 0) | (i & 16 ? SESSION_LOST_CARD : 0);
+        vector<int64_t> fees(durations.size());
+        runBench("calculateParkingFees", 0, ops, [&] {
+            for (long long done = 0; done < ops; done += (long long)durations.size()) {
+                calculateParkingFees(standard, durations.data(), flags.data(), fees.data(), durations.size());
+            }
+            benchSink = fees[123];
+        });
+        long long mismatches = 0;
+        for (size_t i = 0; i < fees.size(); ++i) {
+            mismatches += fees[i] != calculateParkingFee(standard, durations[i], flags[i] & SESSION_OVERNIGHT, flags[i] & SESSION_LOST_CARD);
+        }
+        if (mismatches) cout << "  calculateParkingFees disagrees with calculateParkingFee on " << mismatches << " stays!\n";
+
+        int64_t today = currentDayStart();
+        vector<string> clockTimes, fullTimes;
+        for (int m = 0; m < 1440; ++m) {
+            fullTimes.push_back(formatTime(today + m));
+            clockTimes.push_back(fullTimes.back().substr(11));
+        }
+        const long long parseOps = 10000000;
+        runBench("parseTimestamp (HH:MM)", 0, parseOps, [&] {
+            int64_t total = 0, time;
+            for (long long i = 0; i < parseOps; ++i) {
+                if (parseTimestamp(clockTimes[i % 1440], today, time)) total += time;
+            }
+            benchSink = total;
+        });
+        runBench("parseTimestamp (full)", 0, parseOps, [&] {
+            int64_t total = 0, time;
+            for (long long i = 0; i < parseOps; ++i) {
+                if (parseTimestamp(fullTimes[i % 1440], today, time)) total += time;
+            }
+            benchSink = total;
+        });
+        runBench("writeTimestamp", 0, ops, [&] {
+            char text[TIMESTAMP_LENGTH];
+            int64_t total = 0;
+            for (long long i = 0; i < ops; ++i) total += *(writeTimestamp(text, today + i) - 1);
+            benchSink = total;
+        });
+    }
+    cout << "\n";
+
+
+    for (long long records = 1000; records <= maxRecords; records *= 10) {
+        ParkingLot lot;
+        int parked = (int)min<long long>(records / 2, 50000);
+        benchFill(lot, records, parked);
+
+        mt19937 rng(7);
+        vector<PlateText> hits(4096), misses(4096);
+        for (int i = 0; i < 4096; ++i) {
+            hits[i] = lot.logs.plates[lot.active.rows[rng() % lot.active.size()]];
+            normalizePlate("XX" + to_string(rng()), misses[i]);
+        }
+
+        const long long lookups = 2000000;
+        runBench("findVehicle (hit)", records, lookups, [&] {
+            long long total = 0;
+            for (long long i = 0; i < lookups; ++i) total += findVehicle(lot.plateIndex, lot.logs, hits[i & 4095]);
+            benchSink = total;
+        });
+        runBench("findVehicle (miss)", records, lookups, [&] {
+            long long total = 0;
+            for (long long i = 0; i < lookups; ++i) total += findVehicle(lot.plateIndex, lot.logs, misses[i & 4095]);
+            benchSink = total;
+        });
+
+        const long long scans = 20;
+        runBench("vehicleExit active scan", records, scans, [&] {
+            long long total = 0;
+            for (long long i = 0; i < scans; ++i) total += parkedRowsInArrivalOrder(lot.active).size();
+            benchSink = total;
+        });
+
+        // Two hours of closed sessions with a fee over P200, a quarter into the table
+        SessionQuery query;
+        query.status = QUERY_CLOSED;
+        query.entryFrom = lot.logs.entryTimes[lot.logs.size() / 4];
+        query.entryTo = query.entryFrom + 120;
+        query.feeFrom = 20001;
+        const long long queries = 2000;
+        size_t matched = runSessionQuery(lot, query).size();
+        runBench("query 2h closed fee>200", records, queries, [&] {
+            long long total = 0;
+            for (long long i = 0; i < queries; ++i) total += runSessionQuery(lot, query).size();
+            benchSink = total;
+        });
+        cout << "  query matched " << matched << " of " << lot.logs.size() << " sessions\n";
+
+        // The planner should find exactly the rows a full scan of the table
+        // does; ranges start and end on stored values to test the bounds
+        mt19937 queryRng(7);
+        auto storedRange = [&](const ChunkedArray<int64_t> &column, int64_t &from, int64_t &to) {
+            int64_t a = column[queryRng() % lot.logs.size()], b = column[queryRng() % lot.logs.size()];
+            from = min(a, b);
+            to = max(a, b) + queryRng() % 2;
+        };
+        const int plannerChecks = 100;
+        size_t plannerMismatches = 0;
+        for (int q = 0; q < plannerChecks; ++q) {
+            SessionQuery probe;
+            probe.status = QueryStatus(queryRng() % 3);
+            if (queryRng() & 1) storedRange(lot.logs.entryTimes, probe.entryFrom, probe.entryTo);
+            if (queryRng() & 1) storedRange(lot.logs.exitTimes, probe.exitFrom, probe.exitTo);
+            if (queryRng() & 1) storedRange(lot.logs.fees, probe.feeFrom, probe.feeTo);
+            bool closedTerms = probe.exitFrom != INT64_MIN || probe.exitTo != INT64_MAX || probe.feeFrom != INT64_MIN || probe.feeTo != INT64_MAX;
+            vector<int> scanned;
+            for (size_t row = 0; row < lot.logs.size(); ++row) {
+                bool parked = lot.logs.statuses[row] & SESSION_PARKED;
+                int64_t entry = lot.logs.entryTimes[row], exit = lot.logs.exitTimes[row], fee = lot.logs.fees[row];
+                if ((probe.status == QUERY_OPEN && !parked) || (probe.status == QUERY_CLOSED && parked)) continue;
+                if (entry < probe.entryFrom || entry >= probe.entryTo) continue;
+                if (closedTerms && (parked || exit < probe.exitFrom || exit >= probe.exitTo || fee < probe.feeFrom || fee >= probe.feeTo)) continue;
+                scanned.push_back((int)row);
+            }
+            plannerMismatches += runSessionQuery(lot, probe) != scanned;
+        }
+        cout << "  query planner vs full scan: " << plannerChecks << " queries, " << plannerMismatches << " mismatches\n";
+        runBench("rebuildIndexes", records, records, [&] {
+            rebuildIndexes(lot);
+        });
+
+        // What a dashboard refreshing once a second asks for
+        const long long summaries = 100000;
+        int64_t latest = lot.occupancy.head;
+        runBench("occupancy last hour", records, summaries, [&] {
+            long long total = 0;
+            for (long long i = 0; i < summaries; ++i) total += lot.occupancy.summarize(latest - 59, latest + 1).peak;
+            benchSink = total;
+        });
+        runBench("occupancy last 24h", records, summaries, [&] {
+            long long total = 0;
+            for (long long i = 0; i < summaries; ++i) total += lot.occupancy.summarize(latest - 1439, latest + 1).peak;
+            benchSink = total;
+        });
+
+        runBench("rerateSessions", records, records, [&] {
+            TariffReader reader(lot.tariff);
+            ReportWriter discard(-1);
+            benchSink = rerateSessions(lot.logs, *reader.table, discard).rerated;
+        });
+
+        // One screen of the paged viewer, deep in the table and filtered
+        const long long pages = 20000;
+        LogView view;
+        view.lot = &lot;
+        view.top = lot.logs.size() - LOG_PAGE_ROWS;
+        runBench("log viewer page (last)", records, pages, [&] {
+            for (long long i = 0; i < pages; ++i) {
+                ReportWriter discard(-1, 1 << 14);
+                writeLogPage(discard, view, LOG_PAGE_ROWS);
+                discard.flush();
+            }
+        });
+        view.parkedOnly = true;
+        runBench("log viewer filter (parked)", records, records, [&] {
+            filterLogView(view);
+            benchSink = view.matches.size();
+        });
+
+        // What an operator or camera types at the exit: the tail of a plate,
+        // and a whole plate with one unreadable and one misread character
+        const long long searches = 20000;
+        vector<string> tails, misreads;
+        for (int i = 0; i < 256; ++i) {
+            string plate(hits[i].view());
+            tails.push_back(plate.substr(plate.size() - 5));
+            plate[3] = '?';
+            plate[plate.size() - 2] = plate[plate.size() - 2] == '8' ? '3' : '8';
+            misreads.push_back(plate);
+        }
+        runBench("searchPlates (tail)", records, searches, [&] {
+            long long total = 0;
+            for (long long i = 0; i < searches; ++i) total += searchPlates(lot, tails[i & 255], true, PLATE_SEARCH_LIMIT).size();
+            benchSink = total;
+        });
+        runBench("searchPlates (misread)", records, searches, [&] {
+            long long total = 0;
+            for (long long i = 0; i < searches; ++i) total += searchPlates(lot, misreads[i & 255], false, PLATE_SEARCH_LIMIT).size();
+            benchSink = total;
+        });
+
+        runBench("viewLogs rendering", records, records, [&] {
+            ReportWriter discard(-1);
+            writeLogReport(discard, lot.logs);
+            discard.flush();
+        });
+
+        string path = "epeect_bench_logs.txt";
+        runBench("saveLogsToFile", records, records, [&] {
+            benchSink = writeLogReport(lot.logs, lot.stats, path);
+        });
+        filesystem::remove(path);
+
+        // Four daily reports, each repeating the whole table, as shutdowns leave them
+        string importDirectory = "epeect_bench_import";
+        filesystem::create_directory(importDirectory);
+        for (int day = 1; day <= 4; ++day) {
+            writeLogReport(lot.logs, lot.stats, importDirectory + "/ParkingLogs_2026-01-0" + to_string(day) + "_23-59.txt");
+        }
+        runBench("importLogFiles (4 reports)", records, 4 * records, [&] {
+            ParkingLot imported;
+            imported.bays.init(PARKING_ZONES, TOTAL_SPACES / PARKING_ZONES);
+            ImportCounts counts;
+            benchSink = importLogFiles(imported, importDirectory, counts);
+        });
+        filesystem::remove_all(importDirectory);
+
+        string exportPath = "epeect_bench_export.bin", csvPath = "epeect_bench_export.csv";
+        runBench("exportColumnar", records, records, [&] {
+            benchSink = exportColumnar(lot.logs, exportPath);
+        });
+        runBench("exportCsv", records, records, [&] {
+            benchSink = exportCsv(lot.logs, csvPath);
+        });
+        cout << "  export size: columnar " << filesystem::file_size(exportPath) << " bytes, csv "
+             << filesystem::file_size(csvPath) << " bytes\n";
+
+        // Revenue from the fee column alone against decoding every column
+        runBench("scan export (fees)", records, records, [&] {
+            long long total = 0;
+            scanColumnarExport(exportPath, 1u << EXPORT_FEES, [&](const ExportBlock &block) {
+                for (int64_t fee : block.fees) total += fee;
+            });
+            benchSink = total;
+        });
+        runBench("scan export (all columns)", records, records, [&] {
+            long long total = 0;
+            scanColumnarExport(exportPath, (1u << EXPORT_COLUMN_COUNT) - 1, [&](const ExportBlock &block) {
+                for (int64_t fee : block.fees) total += fee;
+            });
+            benchSink = total;
+        });
+
+        // Every column should come back exactly as it went out
+        size_t row = 0, mismatches = 0;
+        scanColumnarExport(exportPath, (1u << EXPORT_COLUMN_COUNT) - 1, [&](const ExportBlock &block) {
+            for (size_t i = 0; i < block.rows; ++i, ++row) {
+                mismatches += block.plates[i].view() != lot.logs.plates[row].view()
+                           || block.entryTimes[i] != lot.logs.entryTimes[row] || block.fees[i] != lot.logs.fees[row]
+                           || block.exitTimes[i] != ((lot.logs.statuses[row] & SESSION_PARKED) ? -1 : lot.logs.exitTimes[row])
+                           || block.statuses[i] != lot.logs.statuses[row] || block.bays[i] != lot.logs.bays[row];
+            }
+        });
+        cout << "  export round trip: " << row << " rows, " << mismatches << " mismatches\n";
+        filesystem::remove(exportPath);
+        filesystem::remove(csvPath);
+        cout << "\n";
+    }
+    return 0;
 }
+#endif